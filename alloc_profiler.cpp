@@ -0,0 +1,332 @@
+#include "alloc_profiler.h"
+#include "metrics.h"
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Nothing here may allocate with operator new: every table is static and
+// threads only ever write to their own one, so counting is lock-free.
+namespace {
+
+const int MAX_THREADS = 256;
+const int SITE_SLOTS = 4096;  // per thread, power of two
+const int MAX_PHASES = 64;
+const int MERGED_SLOTS = 4 * SITE_SLOTS;
+
+struct SiteCounter {
+    const void* site;  // return address of the operator new call
+    const char* phase;
+    unsigned long long count;
+    unsigned long long bytes;
+};
+
+struct PhaseCounter {
+    const char* phase;
+    unsigned long long count;
+    unsigned long long bytes;
+};
+
+struct ThreadTable {
+    SiteCounter sites[SITE_SLOTS];
+    PhaseCounter phases[MAX_PHASES];
+    int numPhases;
+    unsigned long long frees;
+    unsigned long long unsited;  // allocations whose call site didn't fit
+};
+
+// Zero-initialized (untouched pages cost nothing)
+ThreadTable tables[MAX_THREADS];
+std::atomic<int> numTables{0};
+std::atomic<unsigned long long> untracked{0};  // threads past MAX_THREADS
+
+thread_local const char* threadPhase = nullptr;
+
+// Table of the calling thread; nullptr past MAX_THREADS
+ThreadTable* threadTable() {
+    thread_local int index = numTables.fetch_add(1);
+    return index < MAX_THREADS ? &tables[index] : nullptr;
+}
+
+size_t hashSite(const void* site, const char* phase) {
+    uint64_t key = reinterpret_cast<uintptr_t>(site) ^ (reinterpret_cast<uintptr_t>(phase) << 17);
+    key *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(key >> 40);
+}
+
+// Insert or find (site, phase) in an open-addressing table
+SiteCounter* findSite(SiteCounter* sites, int slots, const void* site, const char* phase) {
+    size_t mask = static_cast<size_t>(slots) - 1;
+    size_t slot = hashSite(site, phase) & mask;
+    for (int probe = 0; probe < slots; probe++, slot = (slot + 1) & mask) {
+        SiteCounter& entry = sites[slot];
+        if (entry.count == 0) {
+            entry.site = site;
+            entry.phase = phase;
+            return &entry;
+        }
+        if (entry.site == site && entry.phase == phase) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void recordAllocation(const void* site, std::size_t size) {
+    countMetric(Metric::ALLOCATIONS);
+    ThreadTable* table = threadTable();
+    if (!table) {
+        untracked.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const char* phase = threadPhase;
+
+    PhaseCounter* phaseCounter = nullptr;
+    for (int i = 0; i < table->numPhases; i++) {
+        if (table->phases[i].phase == phase) {
+            phaseCounter = &table->phases[i];
+            break;
+        }
+    }
+    if (!phaseCounter && table->numPhases < MAX_PHASES) {
+        phaseCounter = &table->phases[table->numPhases++];
+        phaseCounter->phase = phase;
+    }
+    if (phaseCounter) {
+        phaseCounter->count++;
+        phaseCounter->bytes += size;
+    }
+
+    if (SiteCounter* entry = findSite(table->sites, SITE_SLOTS, site, phase)) {
+        entry->count++;
+        entry->bytes += size;
+    } else {
+        table->unsited++;
+    }
+}
+
+void recordFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (ThreadTable* table = threadTable()) {
+        table->frees++;
+    }
+}
+
+void* allocate(std::size_t size, const void* site) {
+    recordAllocation(site, size);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment, const void* site) {
+    recordAllocation(site, size);
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, align, size ? size : 1) == 0) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// "function+0x1a (module+0x3f2a1)" for a call site; needs exported symbols
+void describeSite(const void* site, char* out, size_t length) {
+    Dl_info info;
+    if (!dladdr(site, &info) || !info.dli_fname) {
+        std::snprintf(out, length, "%p", site);
+        return;
+    }
+    const char* module = std::strrchr(info.dli_fname, '/');
+    module = module ? module + 1 : info.dli_fname;
+    uintptr_t moduleOffset = reinterpret_cast<uintptr_t>(site) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+    if (!info.dli_sname) {
+        std::snprintf(out, length, "%s+0x%lx", module, static_cast<unsigned long>(moduleOffset));
+        return;
+    }
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    const char* name = status == 0 && demangled ? demangled : info.dli_sname;
+    uintptr_t offset = reinterpret_cast<uintptr_t>(site) - reinterpret_cast<uintptr_t>(info.dli_saddr);
+    std::snprintf(out, length, "%.90s+0x%lx (%s+0x%lx)", name, static_cast<unsigned long>(offset),
+                  module, static_cast<unsigned long>(moduleOffset));
+    std::free(demangled);
+}
+
+SiteCounter merged[MERGED_SLOTS];
+int order[MERGED_SLOTS];
+
+// Summary at exit: per phase, then the busiest call sites
+struct Report {
+    ~Report() {
+        int used = std::min(numTables.load(), MAX_THREADS);
+        PhaseCounter phases[MAX_PHASES] = {};
+        int numPhases = 0;
+        unsigned long long total = 0, bytes = 0, frees = 0, unsited = 0;
+        for (int t = 0; t < used; t++) {
+            const ThreadTable& table = tables[t];
+            frees += table.frees;
+            unsited += table.unsited;
+            for (int i = 0; i < table.numPhases; i++) {
+                const PhaseCounter& phase = table.phases[i];
+                int p = 0;
+                while (p < numPhases && phases[p].phase != phase.phase) {
+                    p++;
+                }
+                if (p == numPhases && numPhases < MAX_PHASES) {
+                    phases[numPhases++].phase = phase.phase;
+                }
+                if (p < numPhases) {
+                    phases[p].count += phase.count;
+                    phases[p].bytes += phase.bytes;
+                }
+                total += phase.count;
+                bytes += phase.bytes;
+            }
+            for (const SiteCounter& site : table.sites) {
+                if (site.count == 0) {
+                    continue;
+                }
+                if (SiteCounter* entry = findSite(merged, MERGED_SLOTS, site.site, site.phase)) {
+                    entry->count += site.count;
+                    entry->bytes += site.bytes;
+                }
+            }
+        }
+        if (total == 0) {
+            return;
+        }
+
+        unsigned long long frames = getMetricTotal(Metric::FRAMES);
+        std::sort(phases, phases + numPhases,
+                  [](const PhaseCounter& a, const PhaseCounter& b) { return a.count > b.count; });
+        std::fprintf(stderr, "\n=== Allocation profile (%d threads) ===\n", used);
+        std::fprintf(stderr, "%-16s %14s %14s %12s\n", "Phase", "Allocations", "Bytes", "Per frame");
+        for (int p = 0; p < numPhases; p++) {
+            std::fprintf(stderr, "%-16s %14llu %14llu %12.4f\n",
+                         phases[p].phase ? phases[p].phase : "(untagged)", phases[p].count,
+                         phases[p].bytes, frames ? static_cast<double>(phases[p].count) / frames : 0.0);
+        }
+        std::fprintf(stderr, "%-16s %14llu %14llu %12.4f\n", "total", total, bytes,
+                     frames ? static_cast<double>(total) / frames : 0.0);
+        std::fprintf(stderr, "%llu frees, %llu frames simulated", frees, frames);
+        if (untracked.load() > 0 || unsited > 0) {
+            std::fprintf(stderr, ", %llu allocations without a call site", untracked.load() + unsited);
+        }
+        std::fprintf(stderr, "\n");
+
+        int numSites = 0;
+        for (int i = 0; i < MERGED_SLOTS; i++) {
+            if (merged[i].count > 0) {
+                order[numSites++] = i;
+            }
+        }
+        const char* topSetting = std::getenv("FLAPPY_ALLOC_TOP");
+        int top = std::min(numSites, topSetting ? std::atoi(topSetting) : 20);
+        std::partial_sort(order, order + top, order + numSites,
+                          [](int a, int b) { return merged[a].count > merged[b].count; });
+        std::fprintf(stderr, "\nTop %d call sites:\n%14s %14s  %-16s %s\n", top, "Allocations",
+                     "Bytes", "Phase", "Site");
+        char description[256];
+        for (int i = 0; i < top; i++) {
+            const SiteCounter& site = merged[order[i]];
+            describeSite(site.site, description, sizeof(description));
+            std::fprintf(stderr, "%14llu %14llu  %-16s %s\n", site.count, site.bytes,
+                         site.phase ? site.phase : "(untagged)", description);
+        }
+    }
+} report;
+
+} // namespace
+
+const char* currentAllocPhase() {
+    return threadPhase;
+}
+
+AllocPhase::AllocPhase(const char* name) : previous(threadPhase) {
+    threadPhase = name;
+}
+
+AllocPhase::~AllocPhase() {
+    threadPhase = previous;
+}
+
+// Replaced global allocation functions; the call site is the caller of new
+void* operator new(std::size_t size) {
+    return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size, __builtin_return_address(0));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size, __builtin_return_address(0));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment, __builtin_return_address(0));
+}
+
+void operator delete(void* ptr) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    recordFree(ptr);
+    std::free(ptr);
+}
@@ -0,0 +1,43 @@
+#ifndef ALLOC_PROFILER_H
+#define ALLOC_PROFILER_H
+
+// Heap allocation profiler (opt-in: cmake -DFLAPPY_ALLOC_PROFILER=ON)
+// alloc_profiler.cpp replaces the global operator new/delete and counts
+// every allocation, with its size, in a table owned by the allocating
+// thread, keyed by call site (return address) and the thread's current
+// phase. Phases are set with ALLOC_PHASE("name") for the rest of a scope
+// (names must be string literals); the scheduler hands the phase of the
+// thread calling run() to its workers. A summary per phase and the top call
+// sites go to stderr at exit. In normal builds ALLOC_PHASE compiles to
+// nothing.
+
+#ifdef FLAPPY_ALLOC_PROFILER
+
+// Phase of the calling thread (nullptr outside any phase)
+const char* currentAllocPhase();
+
+class AllocPhase {
+public:
+    explicit AllocPhase(const char* name);
+    ~AllocPhase();
+
+    AllocPhase(const AllocPhase&) = delete;
+    AllocPhase& operator=(const AllocPhase&) = delete;
+
+private:
+    const char* previous;
+};
+
+#define ALLOC_PHASE_CONCAT_INNER(a, b) a##b
+#define ALLOC_PHASE_CONCAT(a, b) ALLOC_PHASE_CONCAT_INNER(a, b)
+#define ALLOC_PHASE(name) AllocPhase ALLOC_PHASE_CONCAT(allocPhase, __LINE__)(name)
+
+#else
+
+inline const char* currentAllocPhase() { return nullptr; }
+
+#define ALLOC_PHASE(name) ((void)(name))
+
+#endif
+
+#endif
@@ -0,0 +1,371 @@
+#include "behavior_cloning.h"
+#include "simulation.h"
+#include "game_types.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+// 8-wide float vector (GCC/Clang vector extension, as in genome_distance.cpp)
+typedef float Vec8 __attribute__((vector_size(32)));
+static const size_t LANES = 8;
+
+static inline void load8(Vec8& v, const float* p) {
+    std::memcpy(&v, p, sizeof(v));
+}
+
+static inline float sum8(const Vec8& v) {
+    return ((v[0] + v[4]) + (v[1] + v[5])) + ((v[2] + v[6]) + (v[3] + v[7]));
+}
+
+// Layer kernels of backpropSlice on feature-major activations ([neuron][sample],
+// stride samples per neuron, a multiple of 8). Like the distance tile they are
+// compiled twice (baseline and AVX) with the same lane-wise adds and
+// multiplies in the same order, so both give identical gradients.
+
+// out = relu(weights * in + biases), or the bare sum for the output layer
+__attribute__((always_inline))
+static inline void forwardLayerKernel(const float* in, int inputs, int outputs, size_t stride,
+                                      const float* weights, const float* biases, bool relu,
+                                      float* out) {
+    for (int neuron = 0; neuron < outputs; neuron++) {
+        const float* row = weights + static_cast<size_t>(neuron) * inputs;
+        for (size_t k = 0; k < stride; k += LANES) {
+            Vec8 sum = biases[neuron] + Vec8{};
+            for (int i = 0; i < inputs; i++) {
+                Vec8 x;
+                load8(x, in + i * stride + k);
+                sum += row[i] * x;
+            }
+            if (relu) {
+                sum = sum > 0.0f ? sum : Vec8{};
+            }
+            std::memcpy(out + neuron * stride + k, &sum, sizeof(sum));
+        }
+    }
+}
+
+// Weight and bias gradients of a layer: delta summed over the samples, and
+// delta times each input
+__attribute__((always_inline))
+static inline void layerGradientKernel(const float* delta, const float* in, int inputs,
+                                       int outputs, size_t stride, float* weightGradient,
+                                       float* biasGradient) {
+    for (int neuron = 0; neuron < outputs; neuron++) {
+        const float* d = delta + neuron * stride;
+        float* row = weightGradient + static_cast<size_t>(neuron) * inputs;
+        Vec8 biasSum = {};
+        for (size_t k = 0; k < stride; k += LANES) {
+            Vec8 dk;
+            load8(dk, d + k);
+            biasSum += dk;
+        }
+        biasGradient[neuron] += sum8(biasSum);
+        for (int i = 0; i < inputs; i++) {
+            const float* x = in + i * stride;
+            Vec8 sum = {};
+            for (size_t k = 0; k < stride; k += LANES) {
+                Vec8 dk, xk;
+                load8(dk, d + k);
+                load8(xk, x + k);
+                sum += dk * xk;
+            }
+            row[i] += sum8(sum);
+        }
+    }
+}
+
+// Delta of the layer below: through the weights, then its ReLU
+__attribute__((always_inline))
+static inline void backLayerKernel(const float* delta, int outputs, size_t stride,
+                                   const float* weights, int inputs, const float* activation,
+                                   float* back) {
+    for (int i = 0; i < inputs; i++) {
+        for (size_t k = 0; k < stride; k += LANES) {
+            Vec8 sum = {};
+            for (int neuron = 0; neuron < outputs; neuron++) {
+                Vec8 dk;
+                load8(dk, delta + neuron * stride + k);
+                sum += weights[static_cast<size_t>(neuron) * inputs + i] * dk;
+            }
+            Vec8 a;
+            load8(a, activation + i * stride + k);
+            sum = a > 0.0f ? sum : Vec8{};
+            std::memcpy(back + i * stride + k, &sum, sizeof(sum));
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BEHAVIOR_CLONING_AVX 1
+
+__attribute__((target("avx")))
+static void forwardLayerAVX(const float* in, int inputs, int outputs, size_t stride,
+                            const float* weights, const float* biases, bool relu, float* out) {
+    forwardLayerKernel(in, inputs, outputs, stride, weights, biases, relu, out);
+}
+
+__attribute__((target("avx")))
+static void layerGradientAVX(const float* delta, const float* in, int inputs, int outputs,
+                             size_t stride, float* weightGradient, float* biasGradient) {
+    layerGradientKernel(delta, in, inputs, outputs, stride, weightGradient, biasGradient);
+}
+
+__attribute__((target("avx")))
+static void backLayerAVX(const float* delta, int outputs, size_t stride, const float* weights,
+                         int inputs, const float* activation, float* back) {
+    backLayerKernel(delta, outputs, stride, weights, inputs, activation, back);
+}
+
+static bool hasAVX() {
+    static const bool supported = __builtin_cpu_supports("avx");
+    return supported;
+}
+#endif
+
+static void forwardLayer(const float* in, int inputs, int outputs, size_t stride,
+                         const float* weights, const float* biases, bool relu, float* out) {
+#ifdef BEHAVIOR_CLONING_AVX
+    if (hasAVX()) {
+        forwardLayerAVX(in, inputs, outputs, stride, weights, biases, relu, out);
+        return;
+    }
+#endif
+    forwardLayerKernel(in, inputs, outputs, stride, weights, biases, relu, out);
+}
+
+static void layerGradient(const float* delta, const float* in, int inputs, int outputs,
+                          size_t stride, float* weightGradient, float* biasGradient) {
+#ifdef BEHAVIOR_CLONING_AVX
+    if (hasAVX()) {
+        layerGradientAVX(delta, in, inputs, outputs, stride, weightGradient, biasGradient);
+        return;
+    }
+#endif
+    layerGradientKernel(delta, in, inputs, outputs, stride, weightGradient, biasGradient);
+}
+
+static void backLayer(const float* delta, int outputs, size_t stride, const float* weights,
+                      int inputs, const float* activation, float* back) {
+#ifdef BEHAVIOR_CLONING_AVX
+    if (hasAVX()) {
+        backLayerAVX(delta, outputs, stride, weights, inputs, activation, back);
+        return;
+    }
+#endif
+    backLayerKernel(delta, outputs, stride, weights, inputs, activation, back);
+}
+
+bool heuristicFlap(const std::vector<float>& features) {
+    float velocity = features[1] * 20.0f - 10.0f;
+    float pipeDistance = features[2] * WINDOW_WIDTH;
+    if (pipeDistance > 180.0f) {
+        return velocity > 7.0f;
+    }
+    // Bird's bottom edge relative to the gap centre (gaps are at least 150 high)
+    float bottom = features[4] * (WINDOW_HEIGHT - 50.0f) + BIRD_SIZE * 2;
+    return bottom + 4.0f * velocity > 75.0f;
+}
+
+void recordDemonstrations(const Policy& demonstrator, const Policy& driver, int games,
+                          uint64_t seed, Demonstrations& data, int maxFrames) {
+    std::uniform_real_distribution<float> gapSize(150.0f, 250.0f);
+    std::uniform_real_distribution<float> gapY(200.0f, WINDOW_HEIGHT - 250.0f);
+    auto recordingPolicy = [&demonstrator, &driver, &data](const std::vector<float>& features) -> bool {
+        bool flap = demonstrator(features);
+        data.features.insert(data.features.end(), features.begin(), features.end());
+        data.actions.push_back(flap ? 1.0f : 0.0f);
+        return &driver == &demonstrator ? flap : driver(features);
+    };
+    for (int game = 0; game < games; game++) {
+        Rng stream(seed, static_cast<uint64_t>(game));
+        std::mt19937 course(static_cast<uint32_t>(stream()));
+        GameResult result = simulateGame(course, gapSize, gapY, recordingPolicy, maxFrames);
+        data.frames += result.framesAlive;
+    }
+}
+
+BehaviorCloner::BehaviorCloner(const std::vector<int>& topology, int numThreads, float learningRate)
+    : topology(topology),
+      numParameters(0),
+      learningRate(learningRate),
+      steps(0),
+      scheduler(std::make_unique<WorkStealingScheduler>(std::max(1, numThreads))) {
+    // Flat layout of NeuralNetwork::getWeights: every bias, then every weight
+    for (size_t layer = 1; layer < topology.size(); layer++) {
+        biasOffset.push_back(numParameters);
+        numParameters += topology[layer];
+    }
+    for (size_t layer = 1; layer < topology.size(); layer++) {
+        weightOffset.push_back(numParameters);
+        numParameters += topology[layer] * topology[layer - 1];
+    }
+    firstMoment.assign(numParameters, 0.0f);
+    secondMoment.assign(numParameters, 0.0f);
+}
+
+void BehaviorCloner::initialize(NeuralNetwork& network, Rng& rng) const {
+    std::vector<float> parameters(numParameters, 0.0f);
+    int numLayers = static_cast<int>(topology.size()) - 1;
+    for (int layer = 0; layer < numLayers; layer++) {
+        float stddev = std::sqrt(2.0f / topology[layer]);
+        int numWeights = topology[layer + 1] * topology[layer];
+        for (int w = 0; w < numWeights; w++) {
+            parameters[weightOffset[layer] + w] = stddev * rng.normal();
+        }
+        if (layer < numLayers - 1) {
+            std::fill_n(&parameters[biasOffset[layer]], topology[layer + 1], 0.1f);
+        }
+    }
+    network.setWeights(parameters);
+}
+
+// Forward and backward pass over samples order[begin, end), accumulating the
+// loss gradient. Activations and deltas are kept feature-major
+// ([neuron][sample], like NeuralNetwork::forwardBatch) with the samples
+// padded to a multiple of 8, so the layer kernels above run every inner loop
+// over the samples with one weight broadcast. Padding samples get a zero
+// delta and add nothing.
+void BehaviorCloner::backpropSlice(const std::vector<float>& parameters, const Demonstrations& data,
+                                   const std::vector<size_t>& order, size_t begin, size_t end,
+                                   SliceResult& result) const {
+    result.gradient.assign(numParameters, 0.0f);
+    result.loss = 0.0;
+    result.correct = 0;
+    int count = static_cast<int>(end - begin);
+    int numLayers = static_cast<int>(topology.size()) - 1;
+    if (count <= 0) {
+        return;
+    }
+    size_t stride = static_cast<size_t>(count + LANES - 1) / LANES * LANES;
+
+    std::vector<std::vector<float>>& activations = result.activations;
+    activations.resize(numLayers + 1);
+    activations[0].assign(topology[0] * stride, 0.0f);
+    for (int s = 0; s < count; s++) {
+        const float* row = &data.features[order[begin + s] * data.numFeatures];
+        for (int i = 0; i < topology[0]; i++) {
+            activations[0][i * stride + s] = row[i];
+        }
+    }
+
+    for (int layer = 0; layer < numLayers; layer++) {
+        int inputs = topology[layer];
+        int outputs = topology[layer + 1];
+        const float* weights = &parameters[weightOffset[layer]];
+        const float* biases = &parameters[biasOffset[layer]];
+        bool last = layer == numLayers - 1;
+        activations[layer + 1].resize(outputs * stride);
+        forwardLayer(activations[layer].data(), inputs, outputs, stride, weights, biases, !last,
+                     activations[layer + 1].data());
+        if (last) {
+            float* out = activations[layer + 1].data();
+            for (size_t s = 0; s < outputs * stride; s++) {
+                out[s] = 1.0f / (1.0f + std::exp(-out[s]));
+            }
+        }
+    }
+
+    // Sigmoid output with cross-entropy: the output delta is prediction - target
+    int outputs = topology[numLayers];
+    std::vector<float>& delta = result.delta;
+    delta.assign(outputs * stride, 0.0f);
+    for (int neuron = 0; neuron < outputs; neuron++) {
+        const float* predictions = &activations[numLayers][neuron * stride];
+        for (int s = 0; s < count; s++) {
+            float target = data.actions[order[begin + s]];
+            float prediction = predictions[s];
+            float clamped = std::min(std::max(prediction, 1e-7f), 1.0f - 1e-7f);
+            result.loss -= target * std::log(clamped) + (1.0f - target) * std::log(1.0f - clamped);
+            result.correct += (prediction > 0.5f) == (target > 0.5f);
+            delta[neuron * stride + s] = prediction - target;
+        }
+    }
+
+    std::vector<float>& previousDelta = result.previousDelta;
+    for (int layer = numLayers - 1; layer >= 0; layer--) {
+        int inputs = topology[layer];
+        int layerOutputs = topology[layer + 1];
+        const float* weights = &parameters[weightOffset[layer]];
+        layerGradient(delta.data(), activations[layer].data(), inputs, layerOutputs, stride,
+                      &result.gradient[weightOffset[layer]], &result.gradient[biasOffset[layer]]);
+        if (layer == 0) {
+            break;
+        }
+
+        // Through the weights, then the ReLU of the layer below
+        previousDelta.resize(inputs * stride);
+        backLayer(delta.data(), layerOutputs, stride, weights, inputs, activations[layer].data(),
+                  previousDelta.data());
+        delta.swap(previousDelta);
+    }
+}
+
+// Minibatch Adam over a shuffled pass of the data. Slices are summed in a
+// fixed order, so the result doesn't depend on which thread ran which slice.
+BehaviorCloner::EpochStats BehaviorCloner::trainEpoch(NeuralNetwork& network, const Demonstrations& data,
+                                                      int batchSize, Rng& rng) {
+    const float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-8f;
+    std::vector<float> parameters = network.getWeights();
+    size_t numSamples = data.size();
+    std::vector<size_t> order(numSamples);
+    std::iota(order.begin(), order.end(), 0);
+    for (size_t i = numSamples; i > 1; i--) {
+        std::swap(order[i - 1], order[rng.below(static_cast<uint32_t>(i))]);
+    }
+
+    double totalLoss = 0.0;
+    uint64_t totalCorrect = 0;
+    size_t batch = static_cast<size_t>(std::max(1, batchSize));
+    std::vector<float> gradient(numParameters);
+    for (size_t first = 0; first < numSamples; first += batch) {
+        size_t last = std::min(numSamples, first + batch);
+
+        // Fixed-size slices: the partition, and so every sum, is the same
+        // for any number of threads
+        int numSlices = static_cast<int>((last - first + SLICE_SAMPLES - 1) / SLICE_SAMPLES);
+        if (slices.size() < static_cast<size_t>(numSlices)) {
+            slices.resize(numSlices);
+        }
+        std::vector<WorkStealingScheduler::Task> tasks;
+        for (int slice = 0; slice < numSlices; slice++) {
+            size_t begin = first + static_cast<size_t>(slice) * SLICE_SAMPLES;
+            size_t end = std::min(last, begin + SLICE_SAMPLES);
+            tasks.push_back([this, &parameters, &data, &order, begin, end, slice](int) {
+                backpropSlice(parameters, data, order, begin, end, slices[slice]);
+            });
+        }
+        scheduler->run(tasks);
+
+        std::fill(gradient.begin(), gradient.end(), 0.0f);
+        for (int slice = 0; slice < numSlices; slice++) {
+            const SliceResult& result = slices[slice];
+            for (int p = 0; p < numParameters; p++) {
+                gradient[p] += result.gradient[p];
+            }
+            totalLoss += result.loss;
+            totalCorrect += result.correct;
+        }
+
+        // Adam step on the batch mean gradient
+        steps++;
+        float scale = 1.0f / static_cast<float>(last - first);
+        float correction1 = 1.0f - std::pow(beta1, static_cast<float>(steps));
+        float correction2 = 1.0f - std::pow(beta2, static_cast<float>(steps));
+        for (int p = 0; p < numParameters; p++) {
+            float g = gradient[p] * scale;
+            firstMoment[p] = beta1 * firstMoment[p] + (1.0f - beta1) * g;
+            secondMoment[p] = beta2 * secondMoment[p] + (1.0f - beta2) * g * g;
+            float m = firstMoment[p] / correction1;
+            float v = secondMoment[p] / correction2;
+            parameters[p] -= learningRate * m / (std::sqrt(v) + epsilon);
+        }
+    }
+
+    network.setWeights(parameters);
+    EpochStats stats;
+    stats.loss = static_cast<float>(totalLoss / std::max<size_t>(1, numSamples));
+    stats.accuracy = static_cast<float>(totalCorrect) / std::max<size_t>(1, numSamples);
+    return stats;
+}
@@ -0,0 +1,97 @@
+#ifndef BEHAVIOR_CLONING_H
+#define BEHAVIOR_CLONING_H
+
+#include "neural_network.h"
+#include "rng.h"
+#include "scheduler.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Behavioral cloning: supervised warm start for evolution
+// A demonstrator (the scripted controller below, or a saved agent) plays
+// recorded games; a network of the training topology is then fitted to its
+// (features, flap) pairs by minibatch Adam on binary cross-entropy. Each
+// minibatch is split into slices of SLICE_SAMPLES samples, one task each,
+// and every slice runs the forward and backward pass for all of its samples
+// layer by layer, vectorized over the samples. Slice gradients are summed in
+// slice order, so the result doesn't depend on the thread count.
+
+// Features and decisions of a demonstrator, one row per frame
+struct Demonstrations {
+    int numFeatures = 5;
+    std::vector<float> features;  // numFeatures per sample
+    std::vector<float> actions;   // 1 = flap
+    uint64_t frames = 0;          // frames simulated to record them
+
+    size_t size() const { return actions.size(); }
+};
+
+// Scripted controller: keep the bird's bottom edge above the lowest possible
+// gap edge, looking a few frames ahead. While the next pipe is far away the
+// bird may still be inside the previous one, whose gap the features no
+// longer show, so it only holds its height.
+bool heuristicFlap(const std::vector<float>& features);
+
+using Policy = std::function<bool(const std::vector<float>&)>;
+
+// Play games and append the demonstrator's decision on every frame to data.
+// The driver flies the bird (the demonstrator itself, or the network being
+// trained so the demonstrator labels the states the network gets into).
+// Game g plays the course seeded from the (seed, g) stream.
+void recordDemonstrations(const Policy& demonstrator, const Policy& driver, int games,
+                          uint64_t seed, Demonstrations& data, int maxFrames = 10000);
+
+class BehaviorCloner {
+public:
+    struct EpochStats {
+        float loss;      // mean binary cross-entropy
+        float accuracy;  // decisions matching the demonstrator
+    };
+
+    BehaviorCloner(const std::vector<int>& topology, int numThreads,
+                   float learningRate = 0.003f);
+
+    // Fresh He-initialized weights with slightly positive hidden biases, so
+    // every ReLU starts out active (an evolved agent often has dead units and
+    // then only learns the base flap rate)
+    void initialize(NeuralNetwork& network, Rng& rng) const;
+
+    // One pass over the demonstrations in a shuffled order, updating network
+    EpochStats trainEpoch(NeuralNetwork& network, const Demonstrations& data, int batchSize, Rng& rng);
+
+private:
+    std::vector<int> topology;
+    std::vector<int> biasOffset;    // flat index of each layer's first bias
+    std::vector<int> weightOffset;  // ... and of its first weight
+    int numParameters;
+    float learningRate;
+
+    // Adam state
+    std::vector<float> firstMoment;
+    std::vector<float> secondMoment;
+    uint64_t steps;
+
+    std::unique_ptr<WorkStealingScheduler> scheduler;
+
+    static const int SLICE_SAMPLES = 64;
+
+    // Gradient, summed loss and correct decisions of one slice of a batch,
+    // and its activation/delta buffers (reused from batch to batch)
+    struct SliceResult {
+        std::vector<float> gradient;
+        double loss;
+        int correct;
+        std::vector<std::vector<float>> activations;
+        std::vector<float> delta;
+        std::vector<float> previousDelta;
+    };
+    std::vector<SliceResult> slices;  // grown to the slices of the largest batch
+
+    void backpropSlice(const std::vector<float>& parameters, const Demonstrations& data,
+                       const std::vector<size_t>& order, size_t begin, size_t end,
+                       SliceResult& result) const;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "neural_network.h"
+#include "policy_table.h"
+#include "simulation.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Distill a saved network into a lookup-table policy and measure how well
+// the table reproduces the network: per-decision agreement on states from
+// fresh games, and score parity on identical courses.
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " -m MODEL -o TABLE [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -m, --model FILE          Saved network (from train -o)\n";
+    std::cout << "  -o, --output FILE         Output lookup table\n";
+    std::cout << "  -b, --bins NUM            Bins per feature, 2 to 64 (default: 16)\n";
+    std::cout << "  -n, --sample-games NUM    Games recorded to place bins (default: 200)\n";
+    std::cout << "  -f, --boundary-fraction F Least confident share of states that places bin edges (default: 0.05)\n";
+    std::cout << "  -e, --eval-games NUM      Games for agreement and score parity (default: 200)\n";
+    std::cout << "      --seed NUM            Random seed (default: 1)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string modelFile = "";
+    std::string outputFile = "";
+    int bins = 16;
+    int sampleGames = 200;
+    float boundaryFraction = 0.05f;
+    int evalGames = 200;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-m" || arg == "--model") {
+            if (i + 1 < argc) {
+                modelFile = argv[++i];
+            }
+        } else if (arg == "-o" || arg == "--output") {
+            if (i + 1 < argc) {
+                outputFile = argv[++i];
+            }
+        } else if (arg == "-b" || arg == "--bins") {
+            if (i + 1 < argc) {
+                bins = std::stoi(argv[++i]);
+                if (bins < PolicyTable::MIN_BINS || bins > PolicyTable::MAX_BINS) {
+                    std::cerr << "Error: --bins must be between " << PolicyTable::MIN_BINS
+                              << " and " << PolicyTable::MAX_BINS << "\n";
+                    return 1;
+                }
+            }
+        } else if (arg == "-n" || arg == "--sample-games") {
+            if (i + 1 < argc) {
+                sampleGames = std::stoi(argv[++i]);
+            }
+        } else if (arg == "-f" || arg == "--boundary-fraction") {
+            if (i + 1 < argc) {
+                boundaryFraction = std::stof(argv[++i]);
+            }
+        } else if (arg == "-e" || arg == "--eval-games") {
+            if (i + 1 < argc) {
+                evalGames = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+        }
+    }
+
+    if (modelFile.empty() || outputFile.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    auto network = NeuralNetwork::load(modelFile);
+    if (!network || network->getTopology()[0] != PolicyTable::NUM_FEATURES) {
+        std::cerr << "Error: could not load a 5-input network from " << modelFile << "\n";
+        return 1;
+    }
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> gapSize(150.0f, 250.0f);
+    std::uniform_real_distribution<float> gapY(200.0f, WINDOW_HEIGHT - 250.0f);
+
+    // Network policy that records every state it sees
+    std::vector<PolicyTable::Features> visited;
+    auto recordingPolicy = [&network, &visited](const std::vector<float>& features) -> bool {
+        visited.push_back({features[0], features[1], features[2], features[3], features[4]});
+        return network->forward(features) > 0.5f;
+    };
+
+    // 1. Record visited states
+    for (int game = 0; game < sampleGames; game++) {
+        simulateGame(gen, gapSize, gapY, recordingPolicy, 10000);
+    }
+    std::cout << "Recorded " << visited.size() << " states from " << sampleGames << " games\n";
+
+    // 2. Distill
+    auto startTime = std::chrono::steady_clock::now();
+    PolicyTable table = PolicyTable::distill(*network, visited, bins, boundaryFraction);
+    double distillSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Table: " << table.getBins() << "^5 = " << table.getNumCells() << " cells, "
+              << table.getSizeBytes() / 1024.0 << " KiB, built in " << distillSeconds << " s\n";
+
+    if (!table.save(outputFile)) {
+        std::cerr << "Error: could not write " << outputFile << "\n";
+        return 1;
+    }
+
+    // 3. Agreement on states from fresh games
+    visited.clear();
+    std::vector<unsigned int> courseSeeds(evalGames);
+    for (auto& courseSeed : courseSeeds) {
+        courseSeed = gen();
+    }
+    for (int game = 0; game < evalGames; game++) {
+        std::mt19937 course(courseSeeds[game]);
+        simulateGame(course, gapSize, gapY, recordingPolicy, 10000);
+    }
+    size_t agree = 0;
+    for (const auto& state : visited) {
+        bool networkFlap = network->forward(std::vector<float>(state.begin(), state.end())) > 0.5f;
+        if (table.shouldFlap(state.data()) == networkFlap) {
+            agree++;
+        }
+    }
+    std::cout << "Decision agreement on " << visited.size() << " held-out states: "
+              << 100.0 * agree / std::max<size_t>(1, visited.size()) << "%\n";
+
+    // 4. Score parity: both policies play the same courses
+    auto networkPolicy = [&network](const std::vector<float>& features) -> bool {
+        return network->forward(features) > 0.5f;
+    };
+    auto tablePolicy = [&table](const std::vector<float>& features) -> bool {
+        return table.shouldFlap(features.data());
+    };
+    double networkScore = 0.0, tableScore = 0.0;
+    int sameScore = 0;
+    for (int game = 0; game < evalGames; game++) {
+        std::mt19937 courseA(courseSeeds[game]);
+        std::mt19937 courseB(courseSeeds[game]);
+        GameResult a = simulateGame(courseA, gapSize, gapY, networkPolicy, 10000);
+        GameResult b = simulateGame(courseB, gapSize, gapY, tablePolicy, 10000);
+        networkScore += a.score;
+        tableScore += b.score;
+        if (a.score == b.score) {
+            sameScore++;
+        }
+    }
+    std::cout << "Mean score over " << evalGames << " games: network " << networkScore / evalGames
+              << ", table " << tableScore / evalGames << " (identical in "
+              << 100.0 * sameScore / std::max(1, evalGames) << "% of games)\n";
+
+    // 5. Decision cost
+    const int DECISIONS = 1000000;
+    std::vector<float> probe = {0.5f, 0.5f, 0.5f, 0.5f, 0.0f};
+    int flaps = 0;
+    startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < DECISIONS; i++) {
+        probe[0] = (i % 1000) / 1000.0f;
+        flaps += network->forward(probe) > 0.5f;
+    }
+    double forwardNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - startTime).count() / DECISIONS;
+    startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < DECISIONS; i++) {
+        probe[0] = (i % 1000) / 1000.0f;
+        flaps += table.shouldFlap(probe.data());
+    }
+    double tableNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - startTime).count() / DECISIONS;
+    volatile int sink = flaps;  // keep the timed loops from being optimized away
+    (void)sink;
+    std::cout << "Decision cost: forward() " << forwardNs << " ns, table " << tableNs << " ns\n";
+
+    std::cout << "Saved table to " << outputFile << "\n";
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "neural_network.h"
+#include "rng.h"
+#include "score_stats.h"
+#include "simulation.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Mass evaluation of a saved agent
+// Game i plays the course seeded from the (seed, i) stream, so results do
+// not depend on the thread count. Threads claim blocks of games and keep
+// their own streaming statistics, merged at the end: memory stays constant
+// however many games are played.
+
+using Clock = std::chrono::steady_clock;
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " -m MODEL [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -m, --model FILE          Saved network (from train -o)\n";
+    std::cout << "  -n, --games NUM           Games to play (default: 100000)\n";
+    std::cout << "  -j, --threads NUM         Threads (default: all cores)\n";
+    std::cout << "  -f, --max-frames NUM      Frames before a game counts as survived (default: 10000)\n";
+    std::cout << "  -a, --accuracy A          Relative accuracy of the quantiles (default: 0.01)\n";
+    std::cout << "      --seed NUM            Course seed (default: 1)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string modelFile = "";
+    uint64_t numGames = 100000;
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    int maxFrames = 10000;
+    double accuracy = 0.01;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-m" || arg == "--model") {
+            if (i + 1 < argc) {
+                modelFile = argv[++i];
+            }
+        } else if (arg == "-n" || arg == "--games") {
+            if (i + 1 < argc) {
+                numGames = std::stoull(argv[++i]);
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            if (i + 1 < argc) {
+                numThreads = std::max(1, std::stoi(argv[++i]));
+            }
+        } else if (arg == "-f" || arg == "--max-frames") {
+            if (i + 1 < argc) {
+                maxFrames = std::stoi(argv[++i]);
+            }
+        } else if (arg == "-a" || arg == "--accuracy") {
+            if (i + 1 < argc) {
+                accuracy = std::stod(argv[++i]);
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                seed = std::stoull(argv[++i]);
+            }
+        }
+    }
+
+    if (modelFile.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    auto network = NeuralNetwork::load(modelFile);
+    if (!network || network->getTopology().front() != 5 || network->getTopology().back() != 1) {
+        std::cerr << "Error: could not load a 5-input, 1-output network from " << modelFile << "\n";
+        return 1;
+    }
+
+    std::cout << "Evaluating " << modelFile << " on " << numGames << " games with "
+              << numThreads << " threads (max " << maxFrames << " frames, seed " << seed << ")\n";
+
+    // Games are handed out in blocks to keep the shared counter cold
+    const uint64_t blockGames = 256;
+    std::atomic<uint64_t> nextGame{0};
+    std::atomic<uint64_t> gamesDone{0};
+    std::vector<ScoreStats> threadStats(numThreads, ScoreStats(accuracy));
+
+    auto startTime = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            NeuralNetwork agent = *network;
+            auto agentFunction = [&agent](const std::vector<float>& features) -> bool {
+                return agent.forward(features) > 0.5f;
+            };
+            std::uniform_real_distribution<float> gapSize(150.0f, 250.0f);
+            std::uniform_real_distribution<float> gapY(200.0f, WINDOW_HEIGHT - 250.0f);
+            ScoreStats& stats = threadStats[t];
+            for (;;) {
+                uint64_t first = nextGame.fetch_add(blockGames);
+                if (first >= numGames) {
+                    break;
+                }
+                uint64_t last = std::min(numGames, first + blockGames);
+                for (uint64_t game = first; game < last; game++) {
+                    Rng stream(seed, game);
+                    std::mt19937 course(static_cast<uint32_t>(stream()));
+                    stats.add(simulateGame(course, gapSize, gapY, agentFunction, maxFrames));
+                }
+                gamesDone.fetch_add(last - first, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Progress every few seconds on long runs
+    auto lastReport = startTime;
+    while (gamesDone.load() < numGames) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = Clock::now();
+        if (now - lastReport >= std::chrono::seconds(5)) {
+            uint64_t done = gamesDone.load();
+            double elapsed = std::chrono::duration<double>(now - startTime).count();
+            std::cerr << "  " << done << "/" << numGames << " games, "
+                      << static_cast<uint64_t>(done / elapsed) << " games/sec\n";
+            lastReport = now;
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    ScoreStats total = threadStats[0];
+    for (int t = 1; t < numThreads; t++) {
+        total.merge(threadStats[t]);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n" << numGames << " games in " << seconds << " s ("
+              << std::setprecision(0) << numGames / seconds << " games/sec, "
+              << std::setprecision(1) << total.frames.getMean() * numGames / seconds / 1e6 << std::setprecision(2)
+              << "M frames/sec)\n";
+    if (total.score.getCount() == 0) {
+        return 0;
+    }
+
+    std::cout << "\n" << std::setw(12) << "" << std::setw(12) << "Mean" << std::setw(12) << "Std dev"
+              << std::setw(10) << "Min" << std::setw(10) << "p1" << std::setw(10) << "p50"
+              << std::setw(10) << "p99" << std::setw(10) << "Max" << "\n";
+    auto row = [](const char* name, const RunningStats& stats, const QuantileSketch& quantiles) {
+        std::cout << std::setw(12) << std::left << name << std::right
+                  << std::setw(12) << stats.getMean() << std::setw(12) << std::sqrt(stats.getVariance())
+                  << std::setprecision(0)
+                  << std::setw(10) << stats.getMin() << std::setw(10) << quantiles.quantile(0.01)
+                  << std::setw(10) << quantiles.quantile(0.50) << std::setw(10) << quantiles.quantile(0.99)
+                  << std::setw(10) << stats.getMax() << std::setprecision(2) << "\n";
+    };
+    row("Score", total.score, total.scoreQuantiles);
+    row("Frames", total.frames, total.frameQuantiles);
+    std::cout << "Fitness: mean " << total.fitness.getMean() << ", std dev "
+              << std::sqrt(total.fitness.getVariance()) << " (standard error "
+              << std::sqrt(total.fitness.getVariance() / numGames) << ")\n";
+    std::cout << "Quantiles within " << std::setprecision(1) << 100.0 * accuracy << "% ("
+              << total.scoreQuantiles.getNumBuckets() + total.frameQuantiles.getNumBuckets()
+              << " sketch buckets)\n";
+
+    std::cout << "\nOutcome:\n";
+    const CrashCause outcomes[] = {CrashCause::NONE, CrashCause::CEILING, CrashCause::FLOOR,
+                                   CrashCause::TOP_PIPE, CrashCause::BOTTOM_PIPE};
+    for (CrashCause cause : outcomes) {
+        uint64_t games = total.causes[static_cast<int>(cause)];
+        std::cout << "  " << std::setw(20) << std::left
+                  << (cause == CrashCause::NONE ? "survived" : crashCauseName(cause)) << std::right
+                  << std::setw(10) << games << " (" << std::setw(5)
+                  << 100.0 * games / numGames << "%)\n";
+    }
+
+    return 0;
+}
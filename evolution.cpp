@@ -1,6 +1,12 @@
 #include "evolution.h"
 #include "simulation.h"
+#include "trace.h"
+#include "alloc_profiler.h"
+#include "genome_distance.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <numeric>
 #include <iostream>
 
@@ -14,7 +20,10 @@ Evolution::Evolution(int populationSize,
                      int tournamentSize,
                      std::mt19937& gen,
                      std::uniform_real_distribution<float>& gapSize,
-                     std::uniform_real_distribution<float>& gapY)
+                     std::uniform_real_distribution<float>& gapY,
+                     const std::string& populationFile,
+                     GenomePrecision precision,
+                     bool hugePages)
     : populationSize(populationSize),
       gamesPerEvaluation(gamesPerEvaluation),
       mutationRate(mutationRate),
@@ -24,105 +33,1008 @@ Evolution::Evolution(int populationSize,
       gen(gen),
       gapSize(gapSize),
       gapY(gapY),
+      runSeed(0),
+      generationCount(0),
+      evaluationCount(0),
       topology(topology),
-      population(populationSize, NeuralNetwork(topology, gen)),
-      fitness(populationSize, 0.0f) {
+      fitness(populationSize, 0.0f),
+      numThreads(1),
+      chunkFrames(1000),
+      scheduler(std::make_unique<WorkStealingScheduler>(1)),
+      farm(nullptr),
+      populationChunk(4096),
+      hugePages(hugePages),
+      nextLineageId(0),
+      lineageLog(nullptr),
+      surrogateKeep(1.0f),
+      surrogateExplore(0.0f),
+      gamesSimulated(0),
+      gamesSkipped(0),
+      surrogateCorrelation(0.0f),
+      simulatedAgent(populationSize, 1),
+      predictedFitness(populationSize, 0.0f),
+      fullHorizon(10000),
+      horizon(10000),
+      horizonGrowRate(0.05f),
+      rescoreInterval(0),
+      evaluatedHorizon(10000),
+      evaluationGames(0),
+      evaluationAtCap(0),
+      gamesAtCap(0),
+      framesSimulated(0),
+      framesSaved(0),
+      censoredAgent(populationSize, 0),
+      sharingRadius(0.0f),
+      speciesThreshold(0.0f),
+      distanceSamples(0),
+      numSpecies(0),
+      distanceSeconds(0.0) {
+    NeuralNetwork initial(topology, gen);
+    runSeed = (static_cast<uint64_t>(gen()) << 32) | gen();
+    if (populationFile.empty() && precision == GenomePrecision::FP32 && !hugePages) {
+        population.assign(populationSize, initial);
+        lineage.resize(populationSize);
+        std::iota(lineage.begin(), lineage.end(), 0);
+        nextLineageId = populationSize;
+        return;
+    }
+    
+    // Population in a store (on disk, or in RAM for reduced precision or
+    // huge pages): every record starts as the initial network
+    store = std::make_unique<PopulationStore>();
+    store->setHugePages(hugePages);
+    if (!store->create(populationFile, populationSize, initial.getNumWeights(), topology,
+                       precision)) {
+        store.reset();
+        return;
+    }
+    std::vector<float> genome = initial.getWeights();
+    int buffer = store->current();
+    for (int i = 0; i < populationSize; i++) {
+        store->writeGenome(buffer, i, genome);
+        store->header(buffer, i) = {nextLineageId++, 0.0f, 0};
+    }
+}
+
+Evolution::~Evolution() = default;
+
+// Set number of evaluation threads
+void Evolution::setNumThreads(int numThreads) {
+    this->numThreads = std::max(1, numThreads);
+    scheduler = std::make_unique<WorkStealingScheduler>(this->numThreads);
+}
+
+// Enable or disable surrogate pre-screening
+void Evolution::setSurrogate(float keep, float explore, int neighbours, int archive) {
+    surrogate.reset();
+    if (keep <= 0.0f || keep >= 1.0f) {
+        return;
+    }
+    surrogateKeep = keep;
+    surrogateExplore = std::min(1.0f, std::max(0.0f, explore));
+    int numWeights = store ? store->getNumWeights() : population[0].getNumWeights();
+    surrogate = std::make_unique<FitnessSurrogate>(numWeights, archive, neighbours);
 }
 
-// Evaluate a single agent by running multiple games
-float Evolution::evaluateAgent(NeuralNetwork& agent) {
-    // Create lambda function that uses the neural network
+// Enable or disable the adaptive horizon
+void Evolution::setAdaptiveHorizon(int startFrames, float growRate, int rescoreInterval) {
+    horizon = startFrames > 0 ? std::min(startFrames, fullHorizon) : fullHorizon;
+    horizonGrowRate = growRate;
+    this->rescoreInterval = std::max(0, rescoreInterval);
+}
+
+// Lineage id of agent index in the current generation
+uint64_t Evolution::lineageIdOf(int index) const {
+    return store ? store->header(store->current(), index).lineageId : lineage[index];
+}
+
+// Start logging; the current population goes in first so every later
+// record has its parents in the log. Copies of the first agent (the whole
+// initial population) are stored as plain references to it.
+void Evolution::setLineageLog(LineageLog* log) {
+    lineageLog = log;
+    if (!lineageLog) {
+        return;
+    }
+    std::string records;
+    std::vector<float> first = store ? loadAgent(0).getWeights() : population[0].getWeights();
+    uint64_t firstId = lineageIdOf(0);
+    uint32_t generation = static_cast<uint32_t>(generationCount);
+    LineageLog::encodeKeyframe(records, firstId, NO_PARENT, NO_PARENT, generation, first);
+    for (int i = 1; i < populationSize; i++) {
+        std::vector<float> genome = store ? loadAgent(i).getWeights() : population[i].getWeights();
+        uint64_t id = lineageIdOf(i);
+        if (genome == first && id > firstId) {
+            LineageLog::encodeDelta(records, id, firstId, NO_PARENT, generation, {}, {});
+        } else {
+            LineageLog::encodeKeyframe(records, id, NO_PARENT, NO_PARENT, generation, genome);
+        }
+    }
+    lineageLog->append(std::move(records), populationSize);
+}
+
+// State of a game that is resumed across chunks
+struct Evolution::PendingGame {
+    int index;  // agent * gamesPerEvaluation + game
+    std::mt19937 gen;
+    std::uniform_real_distribution<float> gapSize;
+    std::uniform_real_distribution<float> gapY;
+    GameSession session;
+};
+
+// New game on the course of seed; with huge pages the PendingGame and its
+// control block come from the calling thread's ScratchPool
+std::shared_ptr<Evolution::PendingGame> Evolution::startGame(int index, uint32_t seed,
+                                                             int maxFrames) const {
+    PendingGame pending{index, std::mt19937(seed), gapSize, gapY, GameSession(maxFrames)};
+    if (hugePages) {
+        return std::allocate_shared<PendingGame>(ScratchAllocator<PendingGame>(), std::move(pending));
+    }
+    return std::make_shared<PendingGame>(std::move(pending));
+}
+
+// Agents evaluated together: games index into agents, results per game
+struct Evolution::EvaluationBatch {
+    std::vector<NeuralNetwork>& agents;
+    int firstAgent;
+    std::vector<GameResult> results;
+};
+
+// Games started / still running for one agent
+struct Evolution::AgentProgress {
+    std::atomic<int> started{0};
+    std::atomic<int> remaining{0};
+};
+
+// Simulate one chunk of a game
+void Evolution::runGameChunk(std::shared_ptr<PendingGame> game, int worker,
+                             EvaluationBatch& batch) {
+    int agentIndex = game->index / gamesPerEvaluation;
+    NeuralNetwork& agent = batch.agents[agentIndex];
     auto agentFunction = [&agent](const std::vector<float>& features) -> bool {
         float output = agent.forward(features);
         return output > 0.5f; // Flap if output > 0.5
     };
     
-    // Run multiple games and average fitness
-    float totalFitness = 0.0f;
-    for (int i = 0; i < gamesPerEvaluation; i++) {
-        GameResult result = simulateGame(gen, gapSize, gapY, agentFunction, 10000);
-        totalFitness += result.fitness();
+    bool traced = agentProgress != nullptr;
+    if (traced && game->session.getFrames() == 0 &&
+        agentProgress[agentIndex].started.fetch_add(1) == 0) {
+        Tracer::asyncBegin("evaluateAgent", batch.firstAgent + agentIndex, Tracer::now());
+    }
+    
+    bool finished;
+    {
+        int gameIndex = batch.firstAgent * gamesPerEvaluation + game->index;
+        TRACE_SCOPE(traced && Tracer::sampleGame(gameIndex) ? "simulateGame" : nullptr, gameIndex);
+        finished = game->session.advance(game->gen, game->gapSize, game->gapY,
+                                         agentFunction, chunkFrames);
+    }
+    
+    if (finished) {
+        batch.results[game->index] = game->session.getResult();
+        if (traced && agentProgress[agentIndex].remaining.fetch_sub(1) == 1) {
+            Tracer::asyncEnd("evaluateAgent", batch.firstAgent + agentIndex, Tracer::now());
+        }
+        return;
+    }
+    
+    // Not finished: put the rest at the stealable end of our deque so an
+    // idle thread can pick it up while we move on to fresh games
+    scheduler->push(worker, [this, game, &batch](int w) {
+        runGameChunk(game, w, batch);
+    }, true);
+}
+
+// Evaluate all agents, chunk by chunk when the population is on disk
+void Evolution::evaluatePopulation() {
+    TRACE_SCOPE("evaluate");
+    ALLOC_PHASE("evaluate");
+    evaluatedHorizon = horizon;
+    evaluationGames = 0;
+    evaluationAtCap = 0;
+    if (!store) {
+        evaluateAgents(population, 0);
+    } else {
+        evaluateStoredPopulation();
+    }
+    
+    // Adaptive horizon: re-score the best agent (or every elite) without the
+    // cap, then grow the cap for the next evaluation once enough games reach it.
+    // Scores under the old cap would understate every agent that survives it,
+    // so the surrogate starts over and the next generation is fully simulated.
+    if (horizon < fullHorizon) {
+        bool allElites = rescoreInterval > 0 && evaluationCount % rescoreInterval == 0;
+        rescoreElites(allElites ? std::max(1, static_cast<int>(populationSize * eliteRatio)) : 1);
+        if (evaluationGames > 0 && evaluationAtCap >= horizonGrowRate * evaluationGames) {
+            horizon = std::min(fullHorizon, horizon * 2);
+            if (surrogate) {
+                surrogate->clear();
+            }
+        }
+    }
+    evaluationCount++;
+}
+
+// Evaluate the population store chunk by chunk
+void Evolution::evaluateStoredPopulation() {
+    // Courses are keyed by game index, so every fitness is the same as
+    // evaluating the whole population at once
+    int buffer = store->current();
+    std::vector<NeuralNetwork>& agents = storedAgents;
+    std::vector<float> genome;
+    for (int first = 0; first < populationSize; first += populationChunk) {
+        int last = std::min(populationSize, first + populationChunk);
+        store->prefetch(buffer, last, last + populationChunk);
+        
+        // Decode into the networks of the previous chunk where there are any
+        if (agents.size() > static_cast<size_t>(last - first)) {
+            agents.erase(agents.begin() + (last - first), agents.end());
+        }
+        for (int i = first; i < last; i++) {
+            store->readGenome(buffer, i, genome);
+            size_t k = static_cast<size_t>(i - first);
+            if (k < agents.size()) {
+                agents[k].setWeights(genome);
+            } else {
+                agents.emplace_back(topology, genome);
+            }
+            if (agents[k].getPruneMask() != pruneMask) {
+                agents[k].setPruneMask(pruneMask);
+            }
+        }
+        evaluateAgents(agents, first);
+        
+        // Screened-out agents keep NOT_SIMULATED, so viewers rank them last
+        for (int i = first; i < last; i++) {
+            store->header(buffer, i).fitness = fitness[i];
+        }
+        store->release(buffer, first, last);
+    }
+}
+
+// Evaluate a group of agents: every (agent, game) pair is an independent task
+void Evolution::evaluateAgents(std::vector<NeuralNetwork>& agents, int firstAgent) {
+    const int maxFrames = horizon;
+    int numAgents = static_cast<int>(agents.size());
+    int numGames = numAgents * gamesPerEvaluation;
+    
+    EvaluationBatch batch{agents, firstAgent, std::vector<GameResult>(numGames)};
+    
+    // Flat genomes for the farm and the surrogate
+    std::vector<std::vector<float>> genomes;
+    if (farm || surrogate) {
+        genomes.reserve(numAgents);
+        for (const auto& agent : agents) {
+            genomes.push_back(agent.getWeights());
+        }
+    }
+    
+    // Which agents to simulate (all unless the surrogate screens them)
+    std::vector<float> predictions;
+    std::vector<char> simulate(numAgents, 1);
+    if (surrogate && surrogate->size() > 0) {
+        screenAgents(genomes, firstAgent, predictions, simulate);
+    }
+    std::vector<int> simulated;
+    for (int agent = 0; agent < numAgents; agent++) {
+        if (simulate[agent]) {
+            simulated.push_back(agent);
+        }
+    }
+    int numSimulated = static_cast<int>(simulated.size());
+    gamesSimulated += static_cast<uint64_t>(numSimulated) * gamesPerEvaluation;
+    gamesSkipped += static_cast<uint64_t>(numAgents - numSimulated) * gamesPerEvaluation;
+    
+    // Course seed of every game from its own stream, independent of scheduling
+    std::vector<uint32_t> seeds(numGames);
+    for (int i = 0; i < numGames; i++) {
+        Rng course(runSeed, COURSE_STREAM, evaluationCount,
+                   static_cast<uint64_t>(firstAgent) * gamesPerEvaluation + i);
+        seeds[i] = static_cast<uint32_t>(course());
+    }
+    
+    bool evaluated = false;
+    if (farm) {
+        std::vector<std::vector<float>> farmGenomes;
+        std::vector<uint32_t> farmSeeds;
+        for (int agent : simulated) {
+            farmGenomes.push_back(genomes[agent]);
+            farmSeeds.insert(farmSeeds.end(), seeds.begin() + agent * gamesPerEvaluation,
+                             seeds.begin() + (agent + 1) * gamesPerEvaluation);
+        }
+        std::vector<GameResult> farmResults;
+        evaluated = farm->evaluate(farmGenomes, gamesPerEvaluation, farmSeeds, maxFrames,
+                                   farmResults);
+        if (evaluated) {
+            for (int k = 0; k < numSimulated; k++) {
+                std::copy(farmResults.begin() + k * gamesPerEvaluation,
+                          farmResults.begin() + (k + 1) * gamesPerEvaluation,
+                          batch.results.begin() + simulated[k] * gamesPerEvaluation);
+            }
+        } else {
+            std::cerr << "Warning: no farm workers left, evaluating in-process\n";
+            farm = nullptr;
+        }
+    }
+    
+    if (!evaluated) {
+        agentProgress.reset();
+        if (Tracer::isEnabled()) {
+            agentProgress.reset(new AgentProgress[numAgents]);
+            for (int agent = 0; agent < numAgents; agent++) {
+                agentProgress[agent].remaining = gamesPerEvaluation;
+            }
+        }
+        
+        std::vector<WorkStealingScheduler::Task> tasks;
+        tasks.reserve(numSimulated * gamesPerEvaluation);
+        for (int agent : simulated) {
+            for (int g = 0; g < gamesPerEvaluation; g++) {
+                int i = agent * gamesPerEvaluation + g;
+                tasks.push_back([this, i, maxFrames, &seeds, &batch](int worker) {
+                    runGameChunk(startGame(i, seeds[i], maxFrames), worker, batch);
+                });
+            }
+        }
+        scheduler->run(tasks);
+        agentProgress.reset();
     }
     
-    return totalFitness / gamesPerEvaluation;
+    // Average per agent in game order so the sum is the same for any thread count;
+    // the surrogate's predictions of screened-out agents are kept apart
+    for (int agent = 0; agent < numAgents; agent++) {
+        simulatedAgent[firstAgent + agent] = simulate[agent] != 0;
+        censoredAgent[firstAgent + agent] = 0;
+        if (!simulate[agent]) {
+            fitness[firstAgent + agent] = NOT_SIMULATED;
+            predictedFitness[firstAgent + agent] = predictions[agent];
+            continue;
+        }
+        float totalFitness = 0.0f;
+        for (int i = 0; i < gamesPerEvaluation; i++) {
+            const GameResult& result = batch.results[agent * gamesPerEvaluation + i];
+            totalFitness += result.fitness();
+            framesSimulated += result.framesAlive;
+            if (!result.crashed) {
+                evaluationAtCap++;
+                gamesAtCap++;
+                framesSaved += fullHorizon - maxFrames;
+                censoredAgent[firstAgent + agent] |= maxFrames < fullHorizon;
+            }
+        }
+        evaluationGames += gamesPerEvaluation;
+        fitness[firstAgent + agent] = totalFitness / gamesPerEvaluation;
+    }
+    
+    // Teach the surrogate every simulated genome; explored agents measure it
+    if (surrogate) {
+        for (int agent : simulated) {
+            if (simulate[agent] == 2) {
+                exploredPredicted.push_back(predictions[agent]);
+                exploredActual.push_back(fitness[firstAgent + agent]);
+            }
+            surrogate->add(genomes[agent], fitness[firstAgent + agent]);
+        }
+    }
+}
+
+// Re-score the best count agents at the full horizon on the courses they
+// just played, if the cap cut any of their games short. A capped score only
+// counts the frames the game got to play, so it never exceeds the agent's
+// full-horizon score: once the best agent is re-scored, the best fitness of
+// the evaluation is a full-horizon result.
+void Evolution::rescoreElites(int count) {
+    TRACE_SCOPE("rescore");
+    ALLOC_PHASE("rescore");
+    int numSimulated = static_cast<int>(std::count(simulatedAgent.begin(), simulatedAgent.end(), 1));
+    count = std::min(numSimulated, count);
+    std::vector<int> order(populationSize);
+    std::iota(order.begin(), order.end(), 0);
+    std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                      [this](int a, int b) { return fitness[a] > fitness[b]; });
+    std::vector<int> censored;
+    for (int k = 0; k < count; k++) {
+        if (censoredAgent[order[k]]) {
+            censored.push_back(order[k]);
+        }
+    }
+    if (censored.empty()) {
+        return;
+    }
+    count = static_cast<int>(censored.size());
+    
+    std::vector<NeuralNetwork> agents;
+    agents.reserve(count);
+    for (int index : censored) {
+        agents.push_back(store ? loadAgent(index) : population[index]);
+    }
+    EvaluationBatch batch{agents, 0, std::vector<GameResult>(count * gamesPerEvaluation)};
+    
+    std::vector<WorkStealingScheduler::Task> tasks;
+    tasks.reserve(count * gamesPerEvaluation);
+    for (int k = 0; k < count; k++) {
+        for (int g = 0; g < gamesPerEvaluation; g++) {
+            int i = k * gamesPerEvaluation + g;
+            Rng course(runSeed, COURSE_STREAM, evaluationCount,
+                       static_cast<uint64_t>(censored[k]) * gamesPerEvaluation + g);
+            uint32_t seed = static_cast<uint32_t>(course());
+            tasks.push_back([this, i, seed, &batch](int worker) {
+                runGameChunk(startGame(i, seed, fullHorizon), worker, batch);
+            });
+        }
+    }
+    scheduler->run(tasks);
+    
+    for (int k = 0; k < count; k++) {
+        float totalFitness = 0.0f;
+        for (int g = 0; g < gamesPerEvaluation; g++) {
+            const GameResult& result = batch.results[k * gamesPerEvaluation + g];
+            totalFitness += result.fitness();
+            framesSimulated += result.framesAlive;
+            // Same course, same flight: games past the old cap were at the cap
+            if (result.framesAlive >= evaluatedHorizon) {
+                framesSaved -= fullHorizon - evaluatedHorizon;
+            }
+        }
+        int index = censored[k];
+        fitness[index] = totalFitness / gamesPerEvaluation;
+        censoredAgent[index] = 0;
+        if (store) {
+            store->header(store->current(), index).fitness = fitness[index];
+        }
+    }
+}
+
+// Rank agents by predicted fitness, simulate the best and a random share of the rest
+void Evolution::screenAgents(const std::vector<std::vector<float>>& genomes, int firstAgent,
+                             std::vector<float>& predictions, std::vector<char>& simulate) {
+    TRACE_SCOPE("surrogate");
+    ALLOC_PHASE("surrogate");
+    int numAgents = static_cast<int>(genomes.size());
+    GenomeMatrix queries(numAgents, static_cast<int>(genomes[0].size()));
+    for (int agent = 0; agent < numAgents; agent++) {
+        queries.setRow(agent, genomes[agent]);
+    }
+    queries.computeNorms();
+    surrogate->predict(queries, predictions, *scheduler);
+    
+    std::vector<int> order(numAgents);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return predictions[a] > predictions[b]; });
+    
+    int numKeep = static_cast<int>(std::ceil(surrogateKeep * numAgents));
+    Rng rng(runSeed, SURROGATE_STREAM, evaluationCount, firstAgent);
+    for (int rank = 0; rank < numAgents; rank++) {
+        if (rank < numKeep) {
+            simulate[order[rank]] = 1;
+        } else {
+            simulate[order[rank]] = rng.uniform() < surrogateExplore ? 2 : 0;
+        }
+    }
+}
+
+// Replace the initial population with copies of one agent
+void Evolution::seedPopulation(const NeuralNetwork& agent) {
+    std::vector<float> genome = agent.getWeights();
+    if (!store) {
+        for (auto& member : population) {
+            member.setWeights(genome);
+        }
+        return;
+    }
+    for (int i = 0; i < populationSize; i++) {
+        store->writeGenome(store->current(), i, genome);
+    }
+}
+
+// Materialize one agent of the current generation
+NeuralNetwork Evolution::loadAgent(int index) const {
+    std::vector<float> genome;
+    store->readGenome(store->current(), index, genome);
+    NeuralNetwork agent(topology, genome);
+    if (pruneMask) {
+        agent.setPruneMask(pruneMask);
+    }
+    return agent;
 }
 
 // Tournament selection: pick random agents, return index of best
-int Evolution::tournamentSelect() {
-    std::uniform_int_distribution<int> dist(0, populationSize - 1);
+int Evolution::tournamentSelect(Rng& rng) const {
+    const std::vector<float>& score = selectionFitness.empty() ? fitness : selectionFitness;
     
-    int bestIndex = dist(gen);
-    float bestFitness = fitness[bestIndex];
+    int bestIndex = rng.below(populationSize);
+    float bestFitness = score[bestIndex];
     
     // Pick tournamentSize - 1 more random agents and find best
     for (int i = 1; i < tournamentSize; i++) {
-        int candidateIndex = dist(gen);
-        if (fitness[candidateIndex] > bestFitness) {
+        int candidateIndex = rng.below(populationSize);
+        if (score[candidateIndex] > bestFitness) {
             bestIndex = candidateIndex;
-            bestFitness = fitness[candidateIndex];
+            bestFitness = score[candidateIndex];
         }
     }
     
     return bestIndex;
 }
 
+// Greedy speciation in fitness order: a genome joins the first species
+// whose representative (its fittest member) lies within the threshold, or
+// founds a new one. Rows are taken a block at a time: tasks compare the whole
+// block against every earlier representative, stopping at a row's first
+// match, and against the block itself; a serial pass over the block then
+// makes the choices the one-genome-at-a-time loop would. With
+// distanceSamples > 0 at most that many species are founded, and a genome
+// matching none of them joins the nearest representative.
+std::vector<int> Evolution::assignSpecies(const GenomeMatrix& genomes, std::vector<int>& speciesSize) const {
+    const int BLOCK = 128;
+    const int TASK_ROWS = 16;
+    const int COL_BLOCK = 256;
+    const float thresholdSq = speciesThreshold * speciesThreshold;
+    int maxSpecies = distanceSamples > 0 ? std::min(distanceSamples, populationSize) : populationSize;
+    
+    GenomeMatrix representatives(maxSpecies, genomes.getCols());
+    std::vector<int> species(populationSize);
+    speciesSize.clear();
+    
+    std::vector<int> firstMatch(BLOCK);
+    std::vector<int> nearest(BLOCK);
+    std::vector<float> nearestDistance(BLOCK);
+    std::vector<float> within(BLOCK * BLOCK);  // distances between rows of the block
+    std::vector<int> founders;
+    std::vector<WorkStealingScheduler::Task> tasks;
+    for (int blockBegin = 0; blockBegin < populationSize; blockBegin += BLOCK) {
+        int blockEnd = std::min(populationSize, blockBegin + BLOCK);
+        int count = static_cast<int>(speciesSize.size());
+        bool full = count >= maxSpecies;
+        
+        for (int taskBegin = blockBegin; taskBegin < blockEnd; taskBegin += TASK_ROWS) {
+            tasks.push_back([&, taskBegin, blockBegin, blockEnd, count, full](int) {
+                int taskEnd = std::min(blockEnd, taskBegin + TASK_ROWS);
+                int unmatched = taskEnd - taskBegin;
+                for (int i = taskBegin; i < taskEnd; i++) {
+                    firstMatch[i - blockBegin] = -1;
+                    nearest[i - blockBegin] = -1;
+                    nearestDistance[i - blockBegin] = std::numeric_limits<float>::max();
+                }
+                
+                float tile[TASK_ROWS * COL_BLOCK];
+                for (int colBegin = 0; colBegin < count && unmatched > 0; colBegin += COL_BLOCK) {
+                    int colEnd = std::min(count, colBegin + COL_BLOCK);
+                    squaredDistanceTile(genomes, taskBegin, taskEnd, representatives, colBegin, colEnd,
+                                        tile, COL_BLOCK);
+                    for (int i = taskBegin; i < taskEnd; i++) {
+                        int local = i - blockBegin;
+                        const float* d = tile + (i - taskBegin) * COL_BLOCK;
+                        for (int j = 0; j < colEnd - colBegin && firstMatch[local] < 0; j++) {
+                            if (d[j] < thresholdSq) {
+                                firstMatch[local] = colBegin + j;
+                                unmatched--;
+                            } else if (d[j] < nearestDistance[local]) {
+                                nearestDistance[local] = d[j];
+                                nearest[local] = colBegin + j;
+                            }
+                        }
+                    }
+                }
+                
+                // Unmatched rows may still match a species founded earlier in the block
+                if (unmatched > 0 && !full) {
+                    squaredDistanceTile(genomes, taskBegin, taskEnd, genomes, blockBegin, blockEnd,
+                                        &within[(taskBegin - blockBegin) * BLOCK], BLOCK);
+                }
+            });
+        }
+        scheduler->run(tasks);
+        
+        founders.clear();
+        for (int i = blockBegin; i < blockEnd; i++) {
+            int local = i - blockBegin;
+            int assigned = firstMatch[local];
+            int closest = nearest[local];
+            float closestDistance = nearestDistance[local];
+            for (size_t f = 0; f < founders.size() && assigned < 0; f++) {
+                float d = within[local * BLOCK + (founders[f] - blockBegin)];
+                if (d < thresholdSq) {
+                    assigned = count + static_cast<int>(f);
+                } else if (d < closestDistance) {
+                    closestDistance = d;
+                    closest = count + static_cast<int>(f);
+                }
+            }
+            if (assigned < 0 && static_cast<int>(speciesSize.size()) < maxSpecies) {
+                assigned = static_cast<int>(speciesSize.size());
+                founders.push_back(i);
+                speciesSize.push_back(0);
+            } else if (assigned < 0) {
+                assigned = closest;
+            }
+            species[i] = assigned;
+            speciesSize[assigned]++;
+        }
+        for (size_t f = 0; f < founders.size(); f++) {
+            representatives.copyRow(count + static_cast<int>(f), genomes, founders[f]);
+        }
+    }
+    return species;
+}
+
+// Niche count n_i = sum_j sh(d_ij) with sh = 1 - d^2 / radius^2 inside the
+// radius. Exact mode runs the blocked distance kernel over all pairs, one
+// task per block of rows; sampled mode compares every genome against
+// distanceSamples random genomes and scales the sum up to the population.
+std::vector<float> Evolution::nicheCounts(const GenomeMatrix& genomes) const {
+    const float radiusSq = sharingRadius * sharingRadius;
+    const int ROW_BLOCK = 64;
+    const int COL_BLOCK = 256;
+    int numWeights = genomes.getCols();
+    
+    // Reference genomes: everyone (exact) or a random sample
+    bool sampled = distanceSamples > 0 && distanceSamples < populationSize;
+    std::vector<int> sample;
+    GenomeMatrix references(sampled ? distanceSamples : 0, numWeights);
+    if (sampled) {
+        Rng rng(runSeed, DISTANCE_STREAM, generationCount);
+        std::vector<int> order(populationSize);
+        std::iota(order.begin(), order.end(), 0);
+        for (int i = 0; i < distanceSamples; i++) {
+            int pick = i + static_cast<int>(rng.below(static_cast<uint32_t>(populationSize - i)));
+            std::swap(order[i], order[pick]);
+            sample.push_back(order[i]);
+            references.copyRow(i, genomes, order[i]);
+        }
+    }
+    const GenomeMatrix& columns = sampled ? references : genomes;
+    int numColumns = columns.getRows();
+    
+    std::vector<float> niche(populationSize, 0.0f);
+    std::vector<WorkStealingScheduler::Task> tasks;
+    for (int rowBegin = 0; rowBegin < populationSize; rowBegin += ROW_BLOCK) {
+        tasks.push_back([&, rowBegin](int) {
+            int rowEnd = std::min(populationSize, rowBegin + ROW_BLOCK);
+            std::vector<float> tile(ROW_BLOCK * COL_BLOCK);
+            for (int colBegin = 0; colBegin < numColumns; colBegin += COL_BLOCK) {
+                int colEnd = std::min(numColumns, colBegin + COL_BLOCK);
+                squaredDistanceTile(genomes, rowBegin, rowEnd, columns, colBegin, colEnd,
+                                    tile.data(), COL_BLOCK);
+                for (int i = rowBegin; i < rowEnd; i++) {
+                    const float* d = tile.data() + (i - rowBegin) * COL_BLOCK;
+                    float sum = 0.0f;
+                    for (int j = 0; j < colEnd - colBegin; j++) {
+                        sum += std::max(0.0f, 1.0f - d[j] / radiusSq);
+                    }
+                    niche[i] += sum;
+                }
+            }
+        });
+    }
+    scheduler->run(tasks);
+    
+    if (sampled) {
+        // Remove self-matches, scale the sample up, add self back
+        float scale = static_cast<float>(populationSize - 1) / distanceSamples;
+        std::vector<bool> inSample(populationSize, false);
+        for (int index : sample) {
+            inSample[index] = true;
+        }
+        for (int i = 0; i < populationSize; i++) {
+            float others = niche[i] - (inSample[i] ? 1.0f : 0.0f);
+            niche[i] = 1.0f + others * scale;
+        }
+    }
+    return niche;
+}
+
+// Shared fitness for selection: the ranking score divided by species size
+// and/or niche count. Genomes are packed in ranking order, the order
+// speciation needs.
+void Evolution::computeSelectionFitness(const std::vector<int>& ranking,
+                                        const std::vector<float>& score) {
+    selectionFitness.clear();
+    numSpecies = 0;
+    distanceSeconds = 0.0;
+    if (sharingRadius <= 0.0f && speciesThreshold <= 0.0f) {
+        if (std::find(simulatedAgent.begin(), simulatedAgent.end(), 0) != simulatedAgent.end()) {
+            selectionFitness = score;
+        }
+        return;
+    }
+    
+    TRACE_SCOPE("distance");
+    ALLOC_PHASE("distance");
+    auto startTime = std::chrono::steady_clock::now();
+    
+    const int PACK_BLOCK = 256;
+    int numWeights = store ? store->getNumWeights() : population[0].getNumWeights();
+    GenomeMatrix genomes(populationSize, numWeights);
+    std::vector<WorkStealingScheduler::Task> tasks;
+    for (int blockBegin = 0; blockBegin < populationSize; blockBegin += PACK_BLOCK) {
+        tasks.push_back([&, blockBegin](int) {
+            int blockEnd = std::min(populationSize, blockBegin + PACK_BLOCK);
+            std::vector<float> genome;
+            for (int row = blockBegin; row < blockEnd; row++) {
+                if (store) {
+                    store->readGenome(store->current(), ranking[row], genome);
+                    genomes.setRow(row, genome);
+                } else {
+                    genomes.setRow(row, population[ranking[row]].getWeights());
+                }
+            }
+        });
+    }
+    scheduler->run(tasks);
+    genomes.computeNorms();
+    
+    selectionFitness = score;
+    
+    if (speciesThreshold > 0.0f) {
+        std::vector<int> speciesSize;
+        std::vector<int> species = assignSpecies(genomes, speciesSize);
+        numSpecies = static_cast<int>(speciesSize.size());
+        for (int row = 0; row < populationSize; row++) {
+            int agent = ranking[row];
+            selectionFitness[agent] = score[agent] / speciesSize[species[row]];
+        }
+    }
+    
+    if (sharingRadius > 0.0f) {
+        std::vector<float> niche = nicheCounts(genomes);
+        for (int row = 0; row < populationSize; row++) {
+            int agent = ranking[row];
+            selectionFitness[agent] = score[agent] / std::max(1.0f, niche[row]);
+        }
+    }
+    
+    distanceSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
 // Run one generation: evaluate, select, crossover, mutate
 void Evolution::evolve() {
+    ALLOC_PHASE("evolve");
+    gamesSimulated = 0;
+    gamesSkipped = 0;
+    gamesAtCap = 0;
+    framesSimulated = 0;
+    framesSaved = 0;
+    exploredPredicted.clear();
+    exploredActual.clear();
+    
     // 1. Evaluate all agents
-    for (int i = 0; i < populationSize; i++) {
-        fitness[i] = evaluateAgent(population[i]);
-    }
+    evaluatePopulation();
     
-    // 2. Sort by fitness (best first)
+    // 2. Sort by fitness, screened-out agents by their prediction (best first)
     std::vector<int> indices(populationSize);
-    std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(),
-              [this](int a, int b) { return fitness[a] > fitness[b]; });
+    std::vector<float> score = fitness;
+    {
+        TRACE_SCOPE("sort");
+        ALLOC_PHASE("sort");
+        for (int i = 0; i < populationSize; i++) {
+            if (!simulatedAgent[i]) {
+                score[i] = predictedFitness[i];
+            }
+        }
+        std::iota(indices.begin(), indices.end(), 0);
+        std::sort(indices.begin(), indices.end(),
+                  [&score](int a, int b) { return score[a] > score[b]; });
+    }
+    
+    // Ranking for tournaments (no-op unless sharing, speciation or the
+    // surrogate is on)
+    computeSelectionFitness(indices, score);
     
-    // 3. Create new population
+    // 3. Create new population (in RAM, or in the store's next buffer)
+    TraceScope reproduceSpan("reproduce");
+    ALLOC_PHASE("reproduce");
     std::vector<NeuralNetwork> newPopulation;
-    newPopulation.reserve(populationSize);
+    if (!store) {
+        newPopulation = population;  // slots are overwritten below
+    }
+    int current = store ? store->current() : 0;
+    int next = store ? store->next() : 0;
     
-    // 4. Elitism: keep top eliteRatio% unchanged
-    int eliteSize = static_cast<int>(populationSize * eliteRatio);
-    for (int i = 0; i < eliteSize; i++) {
-        newPopulation.push_back(population[indices[i]]);
+    // 4. Elitism: keep the top eliteRatio% unchanged, simulated agents only
+    int maxElites = static_cast<int>(populationSize * eliteRatio);
+    int eliteSize = 0;
+    std::vector<uint64_t> newLineage(store ? 0 : populationSize);
+    for (int k = 0; k < populationSize && eliteSize < maxElites; k++) {
+        int agent = indices[k];
+        if (!simulatedAgent[agent]) {
+            continue;
+        }
+        if (store) {
+            store->copyRecord(current, agent, next, eliteSize);
+        } else {
+            newPopulation[eliteSize] = population[agent];
+            newLineage[eliteSize] = lineage[agent];
+        }
+        eliteSize++;
     }
     
-    // 5. Fill rest with crossover and mutation
-    while (static_cast<int>(newPopulation.size()) < populationSize) {
-        // Select two parents via tournament selection
-        int parent1Index = tournamentSelect();
-        int parent2Index = tournamentSelect();
-        
-        // Ensure different parents
-        while (parent2Index == parent1Index) {
-            parent2Index = tournamentSelect();
+    // 5. Fill rest with crossover and mutation, one task per block of
+    // children; each child draws from its own stream. Lineage records are
+    // encoded per block and handed to the log in block order.
+    const int CHILD_BLOCK = 256;
+    uint32_t birthGeneration = static_cast<uint32_t>(generationCount + 1);
+    bool logDeltas = lineageLog && !lineageLog->isKeyframe(birthGeneration);
+    std::vector<std::string> blockRecords(
+        lineageLog ? (populationSize - eliteSize + CHILD_BLOCK - 1) / CHILD_BLOCK : 0);
+    std::vector<WorkStealingScheduler::Task> tasks;
+    for (int blockBegin = eliteSize; blockBegin < populationSize; blockBegin += CHILD_BLOCK) {
+        tasks.push_back([&, blockBegin](int) {
+            int blockEnd = std::min(populationSize, blockBegin + CHILD_BLOCK);
+            std::string* records = lineageLog ? &blockRecords[(blockBegin - eliteSize) / CHILD_BLOCK]
+                                              : nullptr;
+            std::vector<uint64_t> mask;
+            std::vector<WeightDelta> deltas;
+            for (int childIndex = blockBegin; childIndex < blockEnd; childIndex++) {
+                Rng rng(runSeed, REPRODUCTION_STREAM, generationCount, childIndex);
+                
+                // Select two parents via tournament selection
+                int parent1Index = tournamentSelect(rng);
+                int parent2Index = tournamentSelect(rng);
+                
+                // Ensure different parents
+                while (parent2Index == parent1Index) {
+                    parent2Index = tournamentSelect(rng);
+                }
+                
+                // Crossover
+                NeuralNetwork child = store
+                    ? NeuralNetwork::crossover(loadAgent(parent1Index), loadAgent(parent2Index), rng,
+                                               logDeltas ? &mask : nullptr)
+                    : NeuralNetwork::crossover(population[parent1Index], population[parent2Index], rng,
+                                               logDeltas ? &mask : nullptr);
+                
+                // Mutate
+                child.mutate(mutationRate, mutationStrength, rng, logDeltas ? &deltas : nullptr);
+                
+                uint64_t childId = nextLineageId + (childIndex - eliteSize);
+                if (logDeltas) {
+                    LineageLog::encodeDelta(*records, childId, lineageIdOf(parent1Index),
+                                            lineageIdOf(parent2Index), birthGeneration, mask, deltas);
+                } else if (lineageLog) {
+                    LineageLog::encodeKeyframe(*records, childId, lineageIdOf(parent1Index),
+                                               lineageIdOf(parent2Index), birthGeneration,
+                                               child.getWeights());
+                }
+                
+                if (!store) {
+                    newPopulation[childIndex] = child;
+                    newLineage[childIndex] = childId;
+                    continue;
+                }
+                store->writeGenome(next, childIndex, child.getWeights());
+                store->header(next, childIndex) = {childId, 0.0f, 0};
+            }
+            
+            // Children of a block are written in order; drop them from RAM
+            if (store) {
+                store->release(next, blockBegin, blockEnd);
+            }
+        });
+    }
+    scheduler->run(tasks);
+    if (lineageLog) {
+        for (size_t block = 0; block < blockRecords.size(); block++) {
+            int blockBegin = eliteSize + static_cast<int>(block) * CHILD_BLOCK;
+            lineageLog->append(std::move(blockRecords[block]),
+                               std::min(CHILD_BLOCK, populationSize - blockBegin));
         }
-        
-        // Crossover
-        NeuralNetwork child = NeuralNetwork::crossover(
-            population[parent1Index],
-            population[parent2Index],
-            gen
-        );
-        
-        // Mutate
-        child.mutate(mutationRate, mutationStrength, gen);
-        
-        newPopulation.push_back(child);
     }
+    nextLineageId += populationSize - eliteSize;
+    generationCount++;
     
     // 6. Replace old population
-    population = newPopulation;
+    if (store) {
+        store->release(current, 0, populationSize);  // parents were read at random
+        store->swapBuffers();
+    } else {
+        population.swap(newPopulation);
+        lineage.swap(newLineage);
+    }
+    reproduceSpan.finish();
     
     // 7. Re-evaluate fitness for new population (for next generation)
+    evaluatePopulation();
+    surrogateCorrelation = rankCorrelation(exploredPredicted, exploredActual);
+}
+
+// Prune the weakest connections of the elites in every agent
+float Evolution::prune(float sparsity) {
+    TRACE_SCOPE("prune");
+    ALLOC_PHASE("prune");
+    int numWeights = store ? store->getNumWeights() : population[0].getNumWeights();
+    int numBiases = 0;
+    for (size_t layer = 1; layer < topology.size(); layer++) {
+        numBiases += topology[layer];
+    }
+    int numConnections = numWeights - numBiases;
+    int already = pruneMask ? pruneMask->numPruned : 0;
+    int target = std::min(numConnections, static_cast<int>(std::lround(sparsity * numConnections)));
+    if (target <= already) {
+        return getSparsity();
+    }
+    
+    // Importance of a connection: its mean magnitude over the elites
+    int numSimulated = static_cast<int>(std::count(simulatedAgent.begin(), simulatedAgent.end(), 1));
+    int eliteCount = std::min(numSimulated, std::max(1, static_cast<int>(populationSize * eliteRatio)));
+    std::vector<int> order(populationSize);
+    std::iota(order.begin(), order.end(), 0);
+    std::partial_sort(order.begin(), order.begin() + eliteCount, order.end(),
+                      [this](int a, int b) { return fitness[a] > fitness[b]; });
+    std::vector<float> importance(numWeights, 0.0f);
+    for (int k = 0; k < eliteCount; k++) {
+        std::vector<float> genome = store ? loadAgent(order[k]).getWeights()
+                                          : population[order[k]].getWeights();
+        for (int gene = numBiases; gene < numWeights; gene++) {
+            importance[gene] += std::fabs(genome[gene]);
+        }
+    }
+    
+    std::vector<uint8_t> pruned = pruneMask ? pruneMask->pruned : std::vector<uint8_t>(numWeights, 0);
+    std::vector<int> candidates;
+    for (int gene = numBiases; gene < numWeights; gene++) {
+        if (!pruned[gene]) {
+            candidates.push_back(gene);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&](int a, int b) { return importance[a] < importance[b]; });
+    for (int k = 0; k < target - already; k++) {
+        pruned[candidates[k]] = 1;
+    }
+    pruneMask = std::make_shared<PruneMask>(topology, pruned);
+    
+    // Zero the pruned weights everywhere; a logged agent that changed becomes
+    // a new genome whose deltas cancel its pruned weights
+    std::string records;
+    uint64_t numRecords = 0;
+    uint32_t generation = static_cast<uint32_t>(generationCount);
+    std::vector<float> genome;
+    std::vector<WeightDelta> deltas;
     for (int i = 0; i < populationSize; i++) {
-        fitness[i] = evaluateAgent(population[i]);
+        if (store) {
+            store->readGenome(store->current(), i, genome);
+        } else {
+            genome = population[i].getWeights();
+        }
+        deltas.clear();
+        for (int gene = numBiases; gene < numWeights; gene++) {
+            if (pruned[gene] && genome[gene] != 0.0f) {
+                deltas.push_back({static_cast<uint32_t>(gene), -genome[gene]});
+                genome[gene] = 0.0f;
+            }
+        }
+        if (store) {
+            store->writeGenome(store->current(), i, genome);
+        } else {
+            population[i].setPruneMask(pruneMask);
+        }
+        if (lineageLog && !deltas.empty()) {
+            uint64_t id = nextLineageId++;
+            LineageLog::encodeDelta(records, id, lineageIdOf(i), NO_PARENT, generation, {}, deltas);
+            numRecords++;
+            if (store) {
+                store->header(store->current(), i).lineageId = id;
+            } else {
+                lineage[i] = id;
+            }
+        }
     }
+    if (numRecords > 0) {
+        lineageLog->append(std::move(records), numRecords);
+    }
+    return getSparsity();
+}
+
+// Fraction of connection weights pruned
+float Evolution::getSparsity() const {
+    return pruneMask && pruneMask->numConnections > 0
+        ? static_cast<float>(pruneMask->numPruned) / pruneMask->numConnections : 0.0f;
 }
 
-// Get best agent
+// Get best agent (screened-out agents hold NOT_SIMULATED, below any real fitness)
 NeuralNetwork Evolution::getBestAgent() const {
     int bestIndex = 0;
     float bestFitness = fitness[0];
@@ -134,7 +1046,13 @@ NeuralNetwork Evolution::getBestAgent() const {
         }
     }
     
-    return population[bestIndex];
+    return store ? loadAgent(bestIndex) : population[bestIndex];
+}
+
+// Lineage id of the best agent
+uint64_t Evolution::getBestLineageId() const {
+    return lineageIdOf(static_cast<int>(std::max_element(fitness.begin(), fitness.end()) -
+                                        fitness.begin()));
 }
 
 // Get best fitness
@@ -144,14 +1062,25 @@ float Evolution::getBestFitness() const {
 
 // Get average fitness
 float Evolution::getAverageFitness() const {
-    float sum = std::accumulate(fitness.begin(), fitness.end(), 0.0f);
-    return sum / populationSize;
+    float best, average, worst;
+    getStatistics(best, average, worst);
+    return average;
 }
 
-// Get statistics
+// Get statistics over the simulated agents (screened-out ones have no real fitness)
 void Evolution::getStatistics(float& best, float& average, float& worst) const {
-    best = *std::max_element(fitness.begin(), fitness.end());
-    worst = *std::min_element(fitness.begin(), fitness.end());
-    average = std::accumulate(fitness.begin(), fitness.end(), 0.0f) / populationSize;
+    best = std::numeric_limits<float>::lowest();
+    worst = std::numeric_limits<float>::max();
+    float sum = 0.0f;
+    int count = 0;
+    for (int i = 0; i < populationSize; i++) {
+        if (simulatedAgent[i]) {
+            best = std::max(best, fitness[i]);
+            worst = std::min(worst, fitness[i]);
+            sum += fitness[i];
+            count++;
+        }
+    }
+    average = sum / count;
 }
 
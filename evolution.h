@@ -3,8 +3,20 @@
 
 #include "neural_network.h"
 #include "simulation.h"
+#include "scheduler.h"
+#include "population_store.h"
+#include "rng.h"
+#include "farm.h"
+#include "surrogate.h"
+#include "lineage_log.h"
+#include <algorithm>
+#include <limits>
+#include <string>
 #include <vector>
 #include <random>
+#include <memory>
+
+class GenomeMatrix;
 
 class Evolution {
 private:
@@ -23,14 +35,146 @@ private:
     std::uniform_real_distribution<float>& gapSize;
     std::uniform_real_distribution<float>& gapY;
     
-    // Evaluate a single agent
-    float evaluateAgent(NeuralNetwork& agent);
+    // Keyed random streams: every course (evaluation, game) and every child
+    // (generation, index) draws from its own Rng, so results don't depend on
+    // how the work is split across threads
+    enum StreamKind : uint64_t {
+        COURSE_STREAM = 1, REPRODUCTION_STREAM = 2, SURROGATE_STREAM = 3, DISTANCE_STREAM = 4
+    };
+    uint64_t runSeed;
+    uint64_t generationCount;
+    uint64_t evaluationCount;
+    
+    // Parallel evaluation: one task per (agent, game), long games are
+    // re-queued every chunkFrames frames so they can migrate between threads
+    int numThreads;
+    int chunkFrames;
+    std::unique_ptr<WorkStealingScheduler> scheduler;
+    
+    // A game that outlived its first chunk and waits to be resumed
+    struct PendingGame;
+    
+    // Per-agent game counts, only tracked while tracing (evaluateAgent spans)
+    struct AgentProgress;
+    std::unique_ptr<AgentProgress[]> agentProgress;
+    
+    // Remote evaluation (nullptr = in-process)
+    EvaluationFarm* farm;
+    
+    // Agents being evaluated together and their game results
+    struct EvaluationBatch;
+    
+    // Out-of-core population: genomes live in a memory-mapped file and are
+    // streamed through RAM populationChunk agents at a time. Also used in
+    // anonymous memory for fp16/bf16 genomes without a file, or on huge
+    // pages. storedAgents holds the decoded chunk and is reused throughout.
+    std::unique_ptr<PopulationStore> store;
+    int populationChunk;
+    std::vector<NeuralNetwork> storedAgents;
+    
+    // Huge-page population, and the PendingGame of every scheduled game from
+    // ScratchPool (see memory_arena.h)
+    bool hugePages;
+    
+    // Lineage ids: unique per genome, kept by elites (in the store's record
+    // headers, or in lineage for an in-memory population)
+    std::vector<uint64_t> lineage;
+    uint64_t nextLineageId;
+    LineageLog* lineageLog;
+    
+    uint64_t lineageIdOf(int index) const;
+    
+    // Materialize one agent of the current generation from the store
+    NeuralNetwork loadAgent(int index) const;
+    
+    // Evaluate all agents (fills fitness)
+    void evaluatePopulation();
+    
+    // Evaluate the population store chunk by chunk (part of evaluatePopulation)
+    void evaluateStoredPopulation();
+    
+    // Evaluate agents [firstAgent, firstAgent + agents.size())
+    void evaluateAgents(std::vector<NeuralNetwork>& agents, int firstAgent);
+    
+    // Set up game index on the course of seed, in ScratchPool with hugePages
+    std::shared_ptr<PendingGame> startGame(int index, uint32_t seed, int maxFrames) const;
+    
+    // Simulate one chunk of a game; re-queues itself if the game isn't over
+    void runGameChunk(std::shared_ptr<PendingGame> game, int worker, EvaluationBatch& batch);
+    
+    // Surrogate pre-screening (nullptr = simulate every agent)
+    std::unique_ptr<FitnessSurrogate> surrogate;
+    float surrogateKeep;
+    float surrogateExplore;
+    uint64_t gamesSimulated;
+    uint64_t gamesSkipped;
+    std::vector<float> exploredPredicted;  // surrogate vs simulated fitness of
+    std::vector<float> exploredActual;     // the randomly explored agents
+    float surrogateCorrelation;
+    
+    // Agents whose fitness comes from games. Screened-out agents have fitness
+    // NOT_SIMULATED and rank in selection by their predictedFitness only;
+    // elites, the best agent and the statistics are always simulated agents.
+    static constexpr float NOT_SIMULATED = std::numeric_limits<float>::lowest();
+    std::vector<char> simulatedAgent;
+    std::vector<float> predictedFitness;
+    
+    // Decide which agents to simulate: 0 = screened out, 1 = predicted
+    // among the best, 2 = explored at random
+    void screenAgents(const std::vector<std::vector<float>>& genomes, int firstAgent,
+                      std::vector<float>& predictions, std::vector<char>& simulate);
+    
+    // Adaptive evaluation horizon: games are capped at horizon frames, which
+    // starts small and doubles whenever at least horizonGrowRate of the games
+    // of an evaluation reach it, up to fullHorizon. A game that reaches the
+    // cap scores what it played so far, and its agent is censored until it
+    // is re-scored at the full horizon; the best agent of every evaluation
+    // is, so the best fitness is never a censored one.
+    int fullHorizon;
+    int horizon;
+    float horizonGrowRate;
+    int rescoreInterval;   // re-score elites at the full horizon every N evaluations (0 = never)
+    int evaluatedHorizon;  // cap of the last evaluation
+    uint64_t evaluationGames;
+    uint64_t evaluationAtCap;
+    uint64_t gamesAtCap;
+    uint64_t framesSimulated;
+    uint64_t framesSaved;
+    std::vector<char> censoredAgent;
+    
+    // Re-evaluate the best count agents on the same courses without the cap
+    // (the censored ones among them)
+    void rescoreElites(int count);
+    
+    // Magnitude pruning shared by every agent (nullptr = dense)
+    std::shared_ptr<const PruneMask> pruneMask;
     
     // Tournament selection: pick random agents, return best
-    int tournamentSelect();
+    int tournamentSelect(Rng& rng) const;
+    
+    // Diversity: fitness sharing within sharingRadius (genome distance) and/or
+    // speciation with speciesThreshold; tournaments use the shared fitness
+    float sharingRadius;
+    float speciesThreshold;
+    int distanceSamples;  // 0 = exact, otherwise sampled references / species cap
+    std::vector<float> selectionFitness;
+    int numSpecies;
+    double distanceSeconds;
+    
+    // Fill selectionFitness (and species) from the ranking score (fitness, or
+    // the prediction of a screened-out agent) and genome distances
+    void computeSelectionFitness(const std::vector<int>& ranking, const std::vector<float>& score);
+    
+    // Species of every row of genomes (rows in fitness order) and species sizes
+    std::vector<int> assignSpecies(const GenomeMatrix& genomes, std::vector<int>& speciesSize) const;
+    
+    // Niche count of every row of genomes
+    std::vector<float> nicheCounts(const GenomeMatrix& genomes) const;
     
 public:
     // Constructor
+    // populationFile: keep the population in this file instead of RAM (optional)
+    // precision: storage precision of genomes between generations
     Evolution(int populationSize,
               const std::vector<int>& topology,
               int gamesPerEvaluation,
@@ -40,11 +184,109 @@ public:
               int tournamentSize,
               std::mt19937& gen,
               std::uniform_real_distribution<float>& gapSize,
-              std::uniform_real_distribution<float>& gapY);
+              std::uniform_real_distribution<float>& gapY,
+              const std::string& populationFile = "",
+              GenomePrecision precision = GenomePrecision::FP32,
+              bool hugePages = false);
+    
+    ~Evolution();
+    
+    // False if the population file could not be created
+    bool isReady() const { return store != nullptr || !population.empty(); }
     
     // Run one generation: evaluate, select, crossover, mutate
     void evolve();
     
+    // Number of evaluation threads (default: 1)
+    void setNumThreads(int numThreads);
+    
+    // Evaluate on a farm of worker processes instead of local threads
+    // (nullptr = in-process); falls back to local threads if every worker is lost
+    void setFarm(EvaluationFarm* farm) { this->farm = farm; }
+    
+    // Frames a game may run before yielding back to the scheduler (default: 1000)
+    void setChunkFrames(int chunkFrames) { this->chunkFrames = std::max(1, chunkFrames); }
+    
+    // Fitness sharing: divide fitness by the niche count within radius (0 = off)
+    void setFitnessSharing(float radius) { sharingRadius = radius; }
+    
+    // Speciation: cluster genomes within threshold, divide fitness by species size (0 = off)
+    void setSpeciation(float threshold) { speciesThreshold = threshold; }
+    
+    // Approximate diversity (0 = exact): estimate niche counts from this many
+    // sampled genomes instead of all pairs, and found at most this many
+    // species (a genome matching none of them joins the nearest)
+    void setDistanceSamples(int samples) { distanceSamples = samples; }
+    
+    // Surrogate pre-screening: simulate only the keep fraction of agents with
+    // the best k-NN predicted fitness, plus an explore fraction of the rest
+    // at random; the others enter tournaments with their prediction but are
+    // never elites, best agent or part of the statistics (keep >= 1 = off).
+    // With a population file agents are ranked within each chunk.
+    void setSurrogate(float keep, float explore, int neighbours = 5, int archive = 2048);
+    
+    // Games simulated / skipped by the surrogate in the last generation
+    uint64_t getGamesSimulated() const { return gamesSimulated; }
+    uint64_t getGamesSkipped() const { return gamesSkipped; }
+    
+    // Spearman correlation of predicted and simulated fitness over the
+    // explored agents of the last generation (0 if there were none)
+    float getSurrogateCorrelation() const { return surrogateCorrelation; }
+    
+    // Record every genome produced from now on in log (nullptr = off); the
+    // current population is written to it right away
+    void setLineageLog(LineageLog* log);
+    
+    // Adaptive horizon: start games at startFrames and grow the cap while at
+    // least growRate of them reach it. Games cut short by the cap keep their
+    // capped fitness; the best agent of each evaluation is re-scored at the
+    // full 10000 frames, and every elite every rescoreInterval evaluations
+    // (startFrames 0 = off). Capped fitness is not normalized, so average and
+    // worst fitness step up when the cap grows; divide by getHorizon() to
+    // compare generations. The surrogate forgets its archive at each step.
+    void setAdaptiveHorizon(int startFrames, float growRate = 0.05f, int rescoreInterval = 0);
+    
+    // Frame cap of the last evaluation
+    int getHorizon() const { return evaluatedHorizon; }
+    
+    // Games that reached the cap in the last generation
+    uint64_t getGamesAtCap() const { return gamesAtCap; }
+    
+    // Frames simulated in the last generation, and at most how many more the
+    // full horizon would have taken (games at the cap might crash soon after)
+    uint64_t getFramesSimulated() const { return framesSimulated; }
+    uint64_t getFramesSaved() const { return framesSaved; }
+    
+    // Magnitude pruning: freeze the connection weights with the smallest mean
+    // |w| over the elites until sparsity of all connection weights (biases
+    // excluded) are pruned. They are zeroed in every agent, stay zero in
+    // children and are skipped by the sparse forward pass. Pruning only ever
+    // grows; with a lineage log, changed agents get a new id whose record
+    // zeroes the weights. Returns the sparsity reached.
+    float prune(float sparsity);
+    
+    // Fraction of connection weights pruned so far
+    float getSparsity() const;
+    
+    // Lineage id of the best agent (see LineageReader::reconstruct)
+    uint64_t getBestLineageId() const;
+    
+    // Agents held in RAM at once with a population file (default: 4096)
+    void setPopulationChunk(int chunk) { populationChunk = std::max(1, chunk); }
+    
+    // Start every agent as a copy of agent (e.g. a behavioral-cloning warm
+    // start). Call before the first evolve() and before setLineageLog().
+    void seedPopulation(const NeuralNetwork& agent);
+    
+    // Memory behind the population records (NORMAL for an in-RAM population)
+    PageKind getPageKind() const { return store ? store->getPageKind() : PageKind::NORMAL; }
+    
+    // Number of species in the last generation (0 if speciation is off)
+    int getSpeciesCount() const { return numSpecies; }
+    
+    // Seconds spent on genome distances in the last generation
+    double getDistanceSeconds() const { return distanceSeconds; }
+    
     // Get best agent
     NeuralNetwork getBestAgent() const;
     
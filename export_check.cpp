@@ -0,0 +1,50 @@
+#include "check_default.h"
+#include "check_deep.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Exported-header test: the headers generated by export_check_record are
+// compiled into this program, and their shouldFlap must make the decision
+// forward() made on every recorded feature vector.
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " DECISIONS\n";
+        return 1;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "Error: could not read " << argv[1] << "\n";
+        return 1;
+    }
+
+    int total = 0;
+    int flaps[2] = {0, 0};
+    int mismatches[2] = {0, 0};
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        float features[5];
+        int expected[2];
+        if (!(fields >> features[0] >> features[1] >> features[2] >> features[3] >> features[4] >>
+              expected[0] >> expected[1])) {
+            std::cerr << "Error: malformed line " << (total + 1) << "\n";
+            return 1;
+        }
+        bool decisions[2] = {check_default::shouldFlap(features), check_deep::shouldFlap(features)};
+        for (int i = 0; i < 2; i++) {
+            flaps[i] += decisions[i];
+            mismatches[i] += decisions[i] != (expected[i] != 0);
+        }
+        total++;
+    }
+
+    const char* names[2] = {"check_default", "check_deep"};
+    for (int i = 0; i < 2; i++) {
+        std::cout << names[i] << ": " << (total - mismatches[i]) << "/" << total
+                  << " decisions match forward() (" << flaps[i] << " flaps)\n";
+    }
+    return total > 0 && mismatches[0] == 0 && mismatches[1] == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include "network_export.h"
+#include "neural_network.h"
+#include "simulation.h"
+#include "game_types.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Fixture for the exported-header test (see export_check.cpp)
+// Exports two networks with train's header exporter and records feature
+// vectors together with the decision forward() makes on each: the features
+// of games every network plays, plus uniformly random feature vectors.
+
+struct Fixture {
+    const char* nameSpace;
+    std::vector<int> topology;
+};
+
+const Fixture FIXTURES[] = {
+    {"check_default", {5, 8, 4, 1}},
+    {"check_deep", {5, 16, 12, 8, 1}},
+};
+const int NUM_FIXTURES = 2;
+const int GAMES = 20;
+const int RANDOM_VECTORS = 20000;
+
+// First network from seed 1 upward that flaps on 10-90% of the random
+// vectors, so both branches of shouldFlap get checked
+static NeuralNetwork pickNetwork(const std::vector<int>& topology,
+                                 const std::vector<std::vector<float>>& randomFeatures) {
+    for (unsigned int seed = 1;; seed++) {
+        std::mt19937 gen(seed);
+        NeuralNetwork network(topology, gen);
+        int flaps = 0;
+        for (const auto& features : randomFeatures) {
+            flaps += network.forward(features) > 0.5f;
+        }
+        float share = static_cast<float>(flaps) / randomFeatures.size();
+        if ((share > 0.1f && share < 0.9f) || seed == 1000) {
+            return network;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " DIR\n";
+        return 1;
+    }
+    std::string directory = argv[1];
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<std::vector<float>> randomFeatures(RANDOM_VECTORS, std::vector<float>(5));
+    for (auto& features : randomFeatures) {
+        for (float& value : features) {
+            value = unit(gen);
+        }
+    }
+
+    std::vector<NeuralNetwork> networks;
+    for (int i = 0; i < NUM_FIXTURES; i++) {
+        networks.push_back(pickNetwork(FIXTURES[i].topology, randomFeatures));
+        std::string header = directory + "/" + FIXTURES[i].nameSpace + ".h";
+        if (!exportNetworkHeader(networks[i], header, FIXTURES[i].nameSpace)) {
+            std::cerr << "Error: could not write " << header << "\n";
+            return 1;
+        }
+    }
+
+    // Feature vectors: games flown by each network, then the random ones
+    std::vector<std::vector<float>> featureStream;
+    std::uniform_real_distribution<float> gapSize(150.0f, 250.0f);
+    std::uniform_real_distribution<float> gapY(200.0f, WINDOW_HEIGHT - 250.0f);
+    for (NeuralNetwork& network : networks) {
+        auto recordingFunction = [&network, &featureStream](const std::vector<float>& features) -> bool {
+            featureStream.push_back(features);
+            return network.forward(features) > 0.5f;
+        };
+        for (int game = 0; game < GAMES; game++) {
+            simulateGame(gen, gapSize, gapY, recordingFunction, 10000);
+        }
+    }
+    featureStream.insert(featureStream.end(), randomFeatures.begin(), randomFeatures.end());
+
+    // One line per vector: 5 features (exact round trip) and each network's decision
+    std::string recordFile = directory + "/decisions.txt";
+    std::ofstream out(recordFile);
+    for (const auto& features : featureStream) {
+        char buffer[32];
+        for (float value : features) {
+            std::snprintf(buffer, sizeof(buffer), "%.9g ", value);
+            out << buffer;
+        }
+        for (NeuralNetwork& network : networks) {
+            out << (network.forward(features) > 0.5f ? 1 : 0) << (&network == &networks.back() ? "\n" : " ");
+        }
+    }
+    if (!out) {
+        std::cerr << "Error: could not write " << recordFile << "\n";
+        return 1;
+    }
+    std::cout << "Recorded " << featureStream.size() << " feature vectors for " << NUM_FIXTURES
+              << " exported networks\n";
+    return 0;
+}
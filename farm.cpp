@@ -0,0 +1,577 @@
+#include "farm.h"
+#include "farm_protocol.h"
+#include "neural_network.h"
+#include "scheduler.h"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+
+// Largest batch a worker accepts (games), to bound memory on bad input
+static const uint32_t FARM_MAX_GAMES = 1u << 22;
+
+// Set a socket to non-blocking mode
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static void setNoDelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// Blocking send/receive of exactly size bytes
+static bool sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+static bool recvAll(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= received;
+    }
+    return true;
+}
+
+// Connect to "host:port"; returns the socket or -1
+static int connectTo(const std::string& address) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        return -1;
+    }
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* candidate = found; candidate && fd < 0; candidate = candidate->ai_next) {
+        fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        if (fd >= 0 && ::connect(fd, candidate->ai_addr, candidate->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    return fd;
+}
+
+// Number of flat weights for a topology
+static size_t countWeights(const std::vector<int>& topology) {
+    size_t count = 0;
+    for (size_t i = 1; i < topology.size(); i++) {
+        count += static_cast<size_t>(topology[i]) * (topology[i - 1] + 1);
+    }
+    return count;
+}
+
+// Constructor
+EvaluationFarm::EvaluationFarm(const std::vector<std::string>& addresses, int batchAgents,
+                               int pipelineDepth)
+    : batchAgents(std::max(1, batchAgents)),
+      pipelineDepth(std::max(1, pipelineDepth)),
+      averageLatency(0.0),
+      batchTimeout(30.0),
+      nextBatchId(0),
+      batchesSent(0),
+      batchesReassigned(0),
+      bytesSent(0),
+      bytesReceived(0) {
+    for (const auto& address : addresses) {
+        Worker worker;
+        worker.address = address;
+        workers.push_back(worker);
+    }
+}
+
+EvaluationFarm::~EvaluationFarm() {
+    for (auto& worker : workers) {
+        disconnect(worker);
+    }
+}
+
+void EvaluationFarm::disconnect(Worker& worker) {
+    if (worker.fd >= 0) {
+        close(worker.fd);
+        worker.fd = -1;
+    }
+    worker.input.clear();
+    worker.output.clear();
+    worker.inFlight.clear();
+}
+
+int EvaluationFarm::getLiveWorkers() const {
+    int live = 0;
+    for (const auto& worker : workers) {
+        live += worker.fd >= 0 ? 1 : 0;
+    }
+    return live;
+}
+
+// Connect and send the hello to every worker
+bool EvaluationFarm::connect(const std::vector<int>& topology,
+                             const std::uniform_real_distribution<float>& gapSize,
+                             const std::uniform_real_distribution<float>& gapY) {
+    if (topology.size() < 2 || topology.size() > FARM_MAX_LAYERS) {
+        return false;
+    }
+    FarmHello hello = {};
+    std::memcpy(hello.magic, FARM_MAGIC, sizeof(FARM_MAGIC));
+    hello.version = FARM_VERSION;
+    hello.numLayers = static_cast<uint32_t>(topology.size());
+    std::copy(topology.begin(), topology.end(), hello.topology);
+    hello.gapSizeMin = gapSize.a();
+    hello.gapSizeMax = gapSize.b();
+    hello.gapYMin = gapY.a();
+    hello.gapYMax = gapY.b();
+
+    for (auto& worker : workers) {
+        worker.fd = connectTo(worker.address);
+        if (worker.fd < 0) {
+            std::cerr << "Warning: could not connect to farm worker " << worker.address << "\n";
+            continue;
+        }
+        setNoDelay(worker.fd);
+        if (!sendAll(worker.fd, &hello, sizeof(hello))) {
+            disconnect(worker);
+            continue;
+        }
+        setNonBlocking(worker.fd);
+    }
+    return getLiveWorkers() > 0;
+}
+
+// Evaluate every agent on the farm
+bool EvaluationFarm::evaluate(const std::vector<std::vector<float>>& genomes, int gamesPerAgent,
+                              const std::vector<uint32_t>& seeds, int maxFrames,
+                              std::vector<GameResult>& results) {
+    int numAgents = static_cast<int>(genomes.size());
+    int numBatches = (numAgents + batchAgents - 1) / batchAgents;
+    uint32_t numWeights = genomes.empty() ? 0 : static_cast<uint32_t>(genomes[0].size());
+    results.resize(static_cast<size_t>(numAgents) * gamesPerAgent);
+
+    // Batch ids are unique across calls, so late answers to batches that were
+    // sent twice in an earlier call are recognized and dropped
+    uint32_t firstBatchId = nextBatchId;
+    nextBatchId += numBatches;
+    auto batchOf = [firstBatchId, numBatches](uint32_t batchId) {
+        uint32_t batch = batchId - firstBatchId;
+        return batch < static_cast<uint32_t>(numBatches) ? static_cast<int>(batch) : -1;
+    };
+
+    std::deque<int> pending;
+    for (int batch = 0; batch < numBatches; batch++) {
+        pending.push_back(batch);
+    }
+    std::vector<char> done(numBatches, 0);
+    std::vector<int> copies(numBatches, 0);  // outstanding on live workers
+    int remaining = numBatches;
+
+    // Queue a batch for a worker (written out when its socket is writable)
+    auto sendBatch = [&](Worker& worker, int batch) {
+        int first = batch * batchAgents;
+        int count = std::min(batchAgents, numAgents - first);
+        FarmBatchHeader header = {firstBatchId + batch, static_cast<uint32_t>(count),
+                                  static_cast<uint32_t>(gamesPerAgent), numWeights, maxFrames};
+        worker.output.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (int agent = first; agent < first + count; agent++) {
+            worker.output.append(reinterpret_cast<const char*>(genomes[agent].data()),
+                                 numWeights * sizeof(float));
+        }
+        worker.output.append(reinterpret_cast<const char*>(seeds.data() + first * gamesPerAgent),
+                             static_cast<size_t>(count) * gamesPerAgent * sizeof(uint32_t));
+        worker.inFlight.push_back({header.batchId, Clock::now()});
+        copies[batch]++;
+        batchesSent++;
+    };
+
+    // A worker went away or hung: everything it held goes back to the queue
+    auto dropWorker = [&](Worker& worker, const char* reason) {
+        std::cerr << "Warning: lost farm worker " << worker.address << " (" << reason << ")\n";
+        for (const auto& entry : worker.inFlight) {
+            int batch = batchOf(entry.batchId);
+            if (batch >= 0) {
+                copies[batch]--;
+            }
+            if (batch >= 0 && !done[batch]) {
+                pending.push_front(batch);
+                batchesReassigned++;
+            }
+        }
+        disconnect(worker);
+    };
+
+    // Parse complete replies from a worker; false on a protocol error
+    auto readReplies = [&](Worker& worker) {
+        while (worker.input.size() >= sizeof(FarmResultHeader)) {
+            FarmResultHeader header;
+            std::memcpy(&header, worker.input.data(), sizeof(header));
+            size_t size = sizeof(header) + static_cast<size_t>(header.numGames) * sizeof(FarmGameResult);
+            if (header.numGames > FARM_MAX_GAMES || worker.inFlight.empty() ||
+                worker.inFlight.front().batchId != header.batchId) {
+                return false;
+            }
+            if (worker.input.size() < size) {
+                break;
+            }
+
+            double latency = std::chrono::duration<double>(
+                Clock::now() - worker.inFlight.front().sent).count();
+            averageLatency = averageLatency == 0.0 ? latency : 0.9 * averageLatency + 0.1 * latency;
+            worker.inFlight.pop_front();
+
+            int batch = batchOf(header.batchId);
+            if (batch >= 0) {
+                copies[batch]--;
+            }
+            if (batch >= 0 && !done[batch]) {
+                int first = batch * batchAgents;
+                int count = std::min(batchAgents, numAgents - first);
+                if (header.numGames != static_cast<uint32_t>(count * gamesPerAgent)) {
+                    return false;
+                }
+                const char* data = worker.input.data() + sizeof(header);
+                for (uint32_t i = 0; i < header.numGames; i++) {
+                    FarmGameResult game;
+                    std::memcpy(&game, data + i * sizeof(game), sizeof(game));
+                    GameResult& result = results[first * gamesPerAgent + i];
+                    result.score = game.score;
+                    result.framesAlive = game.framesAlive;
+                    result.distanceTraveled = game.distanceTraveled;
+                    result.crashed = game.crashed != 0;
+                    result.cause = static_cast<CrashCause>(game.crashed);
+                }
+                done[batch] = 1;
+                remaining--;
+            }
+            worker.input.erase(0, size);
+        }
+        return true;
+    };
+
+    std::vector<pollfd> fds;
+    std::vector<Worker*> polled;
+    char buffer[65536];
+
+    while (remaining > 0) {
+        if (getLiveWorkers() == 0) {
+            return false;
+        }
+
+        // Keep every worker's pipeline full
+        for (auto& worker : workers) {
+            while (worker.fd >= 0 && static_cast<int>(worker.inFlight.size()) < pipelineDepth &&
+                   !pending.empty()) {
+                int batch = pending.front();
+                pending.pop_front();
+                if (!done[batch]) {
+                    sendBatch(worker, batch);
+                }
+            }
+        }
+
+        // Nothing left to hand out: idle workers take over batches that are
+        // overdue elsewhere (at most one extra copy per batch)
+        if (pending.empty()) {
+            double overdue = std::max(0.05, 4.0 * averageLatency);
+            Clock::time_point now = Clock::now();
+            for (auto& idle : workers) {
+                if (idle.fd < 0 || !idle.inFlight.empty()) {
+                    continue;
+                }
+                int slowest = -1;
+                double slowestAge = overdue;
+                for (const auto& other : workers) {
+                    for (const auto& entry : other.inFlight) {
+                        int batch = batchOf(entry.batchId);
+                        double age = std::chrono::duration<double>(now - entry.sent).count();
+                        if (batch >= 0 && !done[batch] && copies[batch] < 2 && age > slowestAge) {
+                            slowest = batch;
+                            slowestAge = age;
+                        }
+                    }
+                }
+                if (slowest >= 0) {
+                    sendBatch(idle, slowest);
+                    batchesReassigned++;
+                }
+            }
+        }
+
+        // Replies come in order, so a worker whose oldest batch is past the
+        // deadline has stopped answering
+        double deadline = std::max(batchTimeout, 10.0 * averageLatency);
+        Clock::time_point now = Clock::now();
+        for (auto& worker : workers) {
+            if (worker.fd >= 0 && !worker.inFlight.empty() &&
+                std::chrono::duration<double>(now - worker.inFlight.front().sent).count() > deadline) {
+                dropWorker(worker, "timed out");
+            }
+        }
+        if (getLiveWorkers() == 0) {
+            return false;
+        }
+
+        fds.clear();
+        polled.clear();
+        for (auto& worker : workers) {
+            if (worker.fd >= 0) {
+                short events = POLLIN | (worker.output.empty() ? 0 : POLLOUT);
+                fds.push_back({worker.fd, events, 0});
+                polled.push_back(&worker);
+            }
+        }
+        if (poll(fds.data(), fds.size(), 50) < 0 && errno != EINTR) {
+            return false;
+        }
+
+        for (size_t i = 0; i < fds.size(); i++) {
+            Worker& worker = *polled[i];
+            bool failed = (fds[i].revents & (POLLERR | POLLNVAL)) != 0;
+
+            if (!failed && !worker.output.empty()) {
+                ssize_t sent = send(worker.fd, worker.output.data(), worker.output.size(), MSG_NOSIGNAL);
+                if (sent > 0) {
+                    bytesSent += sent;
+                    worker.output.erase(0, sent);
+                } else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    failed = true;
+                }
+            }
+
+            if (!failed && (fds[i].revents & (POLLIN | POLLHUP))) {
+                ssize_t received = recv(worker.fd, buffer, sizeof(buffer), 0);
+                if (received > 0) {
+                    bytesReceived += received;
+                    worker.input.append(buffer, received);
+                    failed = !readReplies(worker);
+                } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    failed = true;
+                }
+            }
+
+            if (failed) {
+                dropWorker(worker, "connection lost");
+            }
+        }
+    }
+    return true;
+}
+
+// Serve one master connection until it closes
+static void serveMaster(int fd, WorkStealingScheduler& scheduler) {
+    FarmHello hello;
+    if (!recvAll(fd, &hello, sizeof(hello)) ||
+        !std::equal(hello.magic, hello.magic + 4, FARM_MAGIC) ||
+        hello.version != FARM_VERSION ||
+        hello.numLayers < 2 || hello.numLayers > FARM_MAX_LAYERS) {
+        return;
+    }
+    std::vector<int> topology(hello.topology, hello.topology + hello.numLayers);
+    for (int size : topology) {
+        if (size <= 0) {
+            return;
+        }
+    }
+    size_t expectedWeights = countWeights(topology);
+    const std::uniform_real_distribution<float> gapSize(hello.gapSizeMin, hello.gapSizeMax);
+    const std::uniform_real_distribution<float> gapY(hello.gapYMin, hello.gapYMax);
+
+    std::vector<float> weights;
+    std::vector<uint32_t> seeds;
+    std::vector<NeuralNetwork> agents;
+    std::vector<FarmGameResult> results;
+
+    for (;;) {
+        FarmBatchHeader header;
+        if (!recvAll(fd, &header, sizeof(header)) || header.numWeights != expectedWeights ||
+            header.gamesPerAgent == 0 || header.maxFrames <= 0 ||
+            static_cast<uint64_t>(header.numAgents) * header.gamesPerAgent > FARM_MAX_GAMES) {
+            return;
+        }
+        uint32_t numGames = header.numAgents * header.gamesPerAgent;
+        weights.resize(static_cast<size_t>(header.numAgents) * header.numWeights);
+        seeds.resize(numGames);
+        if (!recvAll(fd, weights.data(), weights.size() * sizeof(float)) ||
+            !recvAll(fd, seeds.data(), seeds.size() * sizeof(uint32_t))) {
+            return;
+        }
+
+        agents.clear();
+        for (uint32_t agent = 0; agent < header.numAgents; agent++) {
+            auto begin = weights.begin() + static_cast<size_t>(agent) * header.numWeights;
+            agents.emplace_back(topology, std::vector<float>(begin, begin + header.numWeights));
+        }
+
+        // Same game as Evolution's in-process path for the same seed
+        results.resize(numGames);
+        std::vector<WorkStealingScheduler::Task> tasks;
+        tasks.reserve(numGames);
+        for (uint32_t i = 0; i < numGames; i++) {
+            tasks.push_back([&, i](int) {
+                NeuralNetwork& agent = agents[i / header.gamesPerAgent];
+                auto agentFunction = [&agent](const std::vector<float>& features) -> bool {
+                    return agent.forward(features) > 0.5f;
+                };
+                std::mt19937 course(seeds[i]);
+                std::uniform_real_distribution<float> gameGapSize = gapSize;
+                std::uniform_real_distribution<float> gameGapY = gapY;
+                GameSession session(header.maxFrames);
+                session.advance(course, gameGapSize, gameGapY, agentFunction, header.maxFrames);
+                const GameResult& result = session.getResult();
+                results[i] = {result.score, result.framesAlive, result.distanceTraveled,
+                              static_cast<uint32_t>(result.cause)};
+            });
+        }
+        scheduler.run(tasks);
+
+        FarmResultHeader reply = {header.batchId, numGames};
+        if (!sendAll(fd, &reply, sizeof(reply)) ||
+            !sendAll(fd, results.data(), results.size() * sizeof(FarmGameResult))) {
+            return;
+        }
+    }
+}
+
+// Worker main loop
+int runFarmWorker(const std::string& address, int port, int numThreads, int readyFd, bool once) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in bindAddress = {};
+    bindAddress.sin_family = AF_INET;
+    bindAddress.sin_port = htons(static_cast<uint16_t>(port));
+    if (listenFd < 0 || inet_pton(AF_INET, address.c_str(), &bindAddress.sin_addr) != 1 ||
+        bind(listenFd, reinterpret_cast<sockaddr*>(&bindAddress), sizeof(bindAddress)) != 0 ||
+        listen(listenFd, 4) != 0) {
+        std::cerr << "Error: farm worker could not listen on " << address << ":" << port << "\n";
+        if (listenFd >= 0) {
+            close(listenFd);
+        }
+        return 1;
+    }
+
+    socklen_t length = sizeof(bindAddress);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&bindAddress), &length);
+    int boundPort = ntohs(bindAddress.sin_port);
+    if (readyFd >= 0) {
+        ssize_t written = write(readyFd, &boundPort, sizeof(boundPort));
+        (void)written;  // the parent treats a short read as a failed start
+        close(readyFd);
+    }
+
+    WorkStealingScheduler scheduler(std::max(1, numThreads));
+    for (;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(listenFd);
+            return 1;
+        }
+        setNoDelay(fd);
+        serveMaster(fd, scheduler);
+        close(fd);
+        if (once) {
+            break;
+        }
+    }
+    close(listenFd);
+    return 0;
+}
+
+// Fork local workers and collect their ports
+bool LocalFarmWorkers::spawn(int count, int threadsPerWorker, std::vector<std::string>& addresses) {
+    for (int i = 0; i < count; i++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        pid_t parent = getpid();
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid == 0) {
+#ifdef __linux__
+            // Die with the parent even if it never gets to stop() (killed, crashed)
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != parent) {
+                _exit(1);
+            }
+#endif
+            (void)parent;
+            close(fds[0]);
+            _exit(runFarmWorker("127.0.0.1", 0, threadsPerWorker, fds[1], true));
+        }
+
+        close(fds[1]);
+        int port = 0;
+        bool ready = read(fds[0], &port, sizeof(port)) == static_cast<ssize_t>(sizeof(port));
+        close(fds[0]);
+        pids.push_back(pid);
+        if (!ready) {
+            return false;
+        }
+        addresses.push_back("127.0.0.1:" + std::to_string(port));
+    }
+    return true;
+}
+
+LocalFarmWorkers::~LocalFarmWorkers() {
+    stop();
+}
+
+void LocalFarmWorkers::stop() {
+    for (pid_t pid : pids) {
+        kill(pid, SIGTERM);
+    }
+    for (pid_t pid : pids) {
+        while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+    }
+    pids.clear();
+}
@@ -0,0 +1,112 @@
+#ifndef FARM_H
+#define FARM_H
+
+#include "simulation.h"
+#include <sys/types.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+// Master side of the evaluation farm
+// Agents are cut into batches of flat genomes plus course seeds and sent to
+// worker processes over TCP (farm_protocol.h). Each worker keeps up to
+// pipelineDepth batches in flight so the network round trip overlaps with
+// simulation. Batches of a dead worker are requeued; once nothing is left
+// to hand out, batches that have been out far longer than usual are sent
+// again to an idle worker and the first answer wins. A worker that holds a
+// batch past its deadline is treated as hung: it is dropped and its batches
+// go to the live workers.
+class EvaluationFarm {
+public:
+    // workers: "host:port" addresses
+    EvaluationFarm(const std::vector<std::string>& workers, int batchAgents = 64,
+                   int pipelineDepth = 4);
+    ~EvaluationFarm();
+
+    EvaluationFarm(const EvaluationFarm&) = delete;
+    EvaluationFarm& operator=(const EvaluationFarm&) = delete;
+
+    // Connect to every worker and send the network/course setup
+    // Returns false if no worker could be reached
+    bool connect(const std::vector<int>& topology,
+                 const std::uniform_real_distribution<float>& gapSize,
+                 const std::uniform_real_distribution<float>& gapY);
+
+    // Play gamesPerAgent games per genome; seeds and results are agent-major
+    // Returns false if every worker has gone away
+    bool evaluate(const std::vector<std::vector<float>>& genomes, int gamesPerAgent,
+                  const std::vector<uint32_t>& seeds, int maxFrames,
+                  std::vector<GameResult>& results);
+
+    // Seconds a batch may be out before its worker counts as hung; the
+    // deadline also grows to 10x the average reply time
+    void setBatchTimeout(double seconds) { batchTimeout = seconds; }
+
+    int getLiveWorkers() const;
+    uint64_t getBatchesSent() const { return batchesSent; }
+    uint64_t getBatchesReassigned() const { return batchesReassigned; }
+    uint64_t getBytesSent() const { return bytesSent; }
+    uint64_t getBytesReceived() const { return bytesReceived; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct InFlight {
+        uint32_t batchId;
+        Clock::time_point sent;
+    };
+
+    struct Worker {
+        std::string address;
+        int fd = -1;
+        std::string input;   // bytes received but not yet parsed
+        std::string output;  // bytes waiting to be sent
+        std::deque<InFlight> inFlight;  // answered in order
+    };
+
+    std::vector<Worker> workers;
+    int batchAgents;
+    int pipelineDepth;
+    double averageLatency;  // seconds from send to reply, moving average
+    double batchTimeout;
+    uint32_t nextBatchId;
+
+    uint64_t batchesSent;
+    uint64_t batchesReassigned;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+
+    void disconnect(Worker& worker);
+};
+
+// Worker side: serve batches on [address:]port with numThreads threads
+// readyFd (if >= 0) receives the bound port as an int once listening.
+// once: exit after the first master disconnects. Returns a process exit code.
+int runFarmWorker(const std::string& address, int port, int numThreads, int readyFd, bool once);
+
+// Worker processes forked on 127.0.0.1 (ephemeral ports) for a local farm
+// They are killed and reaped when this goes out of scope, so every exit path
+// of the parent cleans them up; on Linux they also die with the parent.
+class LocalFarmWorkers {
+public:
+    LocalFarmWorkers() = default;
+    ~LocalFarmWorkers();
+
+    LocalFarmWorkers(const LocalFarmWorkers&) = delete;
+    LocalFarmWorkers& operator=(const LocalFarmWorkers&) = delete;
+
+    // Fork count workers; call before any threads are started. Appends their
+    // addresses; false if one failed to start.
+    bool spawn(int count, int threadsPerWorker, std::vector<std::string>& addresses);
+
+    // Kill and reap every worker
+    void stop();
+
+private:
+    std::vector<pid_t> pids;
+};
+
+#endif
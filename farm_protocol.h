@@ -0,0 +1,48 @@
+#ifndef FARM_PROTOCOL_H
+#define FARM_PROTOCOL_H
+
+#include <cstdint>
+
+// Wire format of the evaluation farm (TCP, little-endian hosts assumed)
+// The master opens one connection per worker and sends a FarmHello, then
+// any number of batches without waiting for replies; the worker answers
+// every batch with its results, in order.
+
+const char FARM_MAGIC[4] = {'F', 'F', 'R', 'M'};
+const uint32_t FARM_VERSION = 1;
+const int FARM_MAX_LAYERS = 16;
+
+// Course and network shape, fixed for the whole connection
+struct FarmHello {
+    char magic[4];
+    uint32_t version;
+    uint32_t numLayers;
+    int32_t topology[FARM_MAX_LAYERS];
+    float gapSizeMin, gapSizeMax;  // uniform_real_distribution ranges of the course
+    float gapYMin, gapYMax;
+};
+
+// A batch: numAgents flat genomes (numWeights floats each), then
+// numAgents * gamesPerAgent course seeds (uint32, agent-major)
+struct FarmBatchHeader {
+    uint32_t batchId;
+    uint32_t numAgents;
+    uint32_t gamesPerAgent;
+    uint32_t numWeights;
+    int32_t maxFrames;  // frame cap of every game
+};
+
+// Reply: numGames results in the order of the batch's seeds
+struct FarmResultHeader {
+    uint32_t batchId;
+    uint32_t numGames;
+};
+
+struct FarmGameResult {
+    int32_t score;
+    int32_t framesAlive;
+    float distanceTraveled;
+    uint32_t crashed;  // CrashCause, 0 = survived
+};
+
+#endif
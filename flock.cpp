@@ -0,0 +1,151 @@
+#include "flock.h"
+#include <algorithm>
+#include <cmath>
+
+// Constructor: same course distributions as the trainer
+Flock::Flock(const std::vector<int>& topology)
+    : topology(topology),
+      numWeights(0),
+      alive(0),
+      score(0),
+      frames(0),
+      maxFrames(0),
+      pipeSpawnCounter(0),
+      gapSize(150.0f, 250.0f),
+      gapY(200.0f, WINDOW_HEIGHT - 250.0f) {
+    int widest = 0;
+    for (size_t layer = 1; layer < topology.size(); layer++) {
+        numWeights += topology[layer] * (topology[layer - 1] + 1);
+        widest = std::max(widest, topology[layer]);
+    }
+    scratch.resize(2 * std::max(widest, topology[0]));
+}
+
+// Add a bird
+void Flock::addGenome(const std::vector<float>& genome) {
+    size_t offset = genomes.size();
+    genomes.resize(offset + numWeights, 0.0f);
+    std::copy(genome.begin(), genome.begin() + std::min<size_t>(genome.size(), numWeights),
+              genomes.begin() + offset);
+    birds.emplace_back();
+    results.emplace_back();
+}
+
+// Swap a bird's genome without touching its state
+void Flock::setGenome(int bird, const std::vector<float>& genome) {
+    auto offset = genomes.begin() + static_cast<size_t>(bird) * numWeights;
+    std::fill(offset, offset + numWeights, 0.0f);
+    std::copy(genome.begin(), genome.begin() + std::min<size_t>(genome.size(), numWeights), offset);
+}
+
+// Start a new round: every bird alive at the start position
+void Flock::reset(unsigned int seed, int maxFrames) {
+    this->maxFrames = maxFrames;
+    gen.seed(seed);
+    pipes.clear();
+    score = 0;
+    frames = 0;
+    pipeSpawnCounter = 0;
+    alive = size();
+    for (int i = 0; i < size(); i++) {
+        birds[i] = {100.0f, WINDOW_HEIGHT / 2.0f, 0.0f, 0.0f};
+        results[i] = {0, 0.0f, -1, false};
+    }
+}
+
+// Dense forward pass over a flat genome: biases of every layer first, then
+// weights [layer][neuron][input] (the layout of NeuralNetwork::getWeights)
+float Flock::forward(const float* genome, const float* features) {
+    size_t half = scratch.size() / 2;
+    float* current = scratch.data();
+    float* next = scratch.data() + half;
+    std::copy(features, features + topology[0], current);
+
+    const float* bias = genome;
+    const float* weight = genome;
+    for (size_t layer = 1; layer < topology.size(); layer++) {
+        weight += topology[layer];
+    }
+
+    size_t numLayers = topology.size() - 1;
+    for (size_t layer = 0; layer < numLayers; layer++) {
+        int inputs = topology[layer];
+        for (int neuron = 0; neuron < topology[layer + 1]; neuron++) {
+            float sum = bias[neuron];
+            for (int input = 0; input < inputs; input++) {
+                sum += weight[input] * current[input];
+            }
+            weight += inputs;
+            next[neuron] = layer == numLayers - 1 ? 1.0f / (1.0f + std::exp(-sum))
+                                                  : std::max(0.0f, sum);
+        }
+        bias += topology[layer + 1];
+        std::swap(current, next);
+    }
+    return current[0];
+}
+
+// One frame, in the order of GameSession::advance: every living bird
+// decides, moves and is checked against the pipes, then the course moves
+bool Flock::step() {
+    if (alive == 0 || (maxFrames > 0 && frames >= maxFrames)) {
+        return false;
+    }
+
+    float features[5];
+    for (int i = 0; i < size(); i++) {
+        if (!isAlive(i)) {
+            continue;
+        }
+        Bird& bird = birds[i];
+        extractFeatures(bird, pipes, features);
+        if (forward(genomes.data() + static_cast<size_t>(i) * numWeights, features) > 0.5f) {
+            bird.vy = JUMP_VELOCITY;
+        }
+        bird.vy += GRAVITY;
+        bird.y += bird.vy;
+        bird.x += bird.vx;
+
+        CrashCause cause = collisionCause(bird, pipes);
+        if (cause != CrashCause::NONE) {
+            results[i] = {score, bird.x, frames, true, cause};
+            alive--;
+        }
+    }
+
+    // Generate new pipes
+    const int PIPE_SPAWN_INTERVAL = 120;
+    pipeSpawnCounter++;
+    if (pipeSpawnCounter >= PIPE_SPAWN_INTERVAL) {
+        Pipe pipe;
+        pipe.x = WINDOW_WIDTH;
+        pipe.gap = gapSize(gen);
+        pipe.gapY = gapY(gen);
+        pipes.push_back(pipe);
+        pipeSpawnCounter = 0;
+    }
+
+    // Move pipes; every bird flies at the same x, so they pass pipes together
+    for (auto& pipe : pipes) {
+        pipe.x -= SCROLL_SPEED;
+        if (!pipe.passed && pipe.x + PIPE_WIDTH < 100.0f) {
+            score++;
+            pipe.passed = true;
+        }
+    }
+    pipes.erase(std::remove_if(pipes.begin(), pipes.end(),
+                               [](const Pipe& p) { return p.x < -PIPE_WIDTH; }),
+                pipes.end());
+    frames++;
+
+    // Round over by frame cap: the survivors finish without crashing
+    if (maxFrames > 0 && frames >= maxFrames) {
+        for (int i = 0; i < size(); i++) {
+            if (isAlive(i)) {
+                results[i] = {score, birds[i].x, frames, false};
+            }
+        }
+        alive = 0;
+    }
+    return alive > 0;
+}
@@ -0,0 +1,63 @@
+#ifndef FLOCK_H
+#define FLOCK_H
+
+#include "game_types.h"
+#include "simulation.h"
+#include <random>
+#include <vector>
+
+// Many birds on one shared course, each flown by its own genome
+// Every bird sees exactly the pipes a headless game with the same seed
+// would give it, so its result matches simulateGame for that course.
+// Genomes are packed back to back and run through a dense forward pass on
+// the flat layout of NeuralNetwork::getWeights, without allocating per frame.
+class Flock {
+public:
+    explicit Flock(const std::vector<int>& topology);
+
+    // Add a bird flown by genome (call before reset)
+    void addGenome(const std::vector<float>& genome);
+
+    // Replace the genome of a bird, mid-flight if need be
+    void setGenome(int bird, const std::vector<float>& genome);
+
+    // Start a new round on the course of seed; maxFrames 0 = no cap
+    void reset(unsigned int seed, int maxFrames = 0);
+
+    // Simulate one frame for every living bird; false once the round is over
+    bool step();
+
+    int size() const { return static_cast<int>(birds.size()); }
+    int getAlive() const { return alive; }
+    bool isAlive(int bird) const { return results[bird].framesAlive < 0; }
+    const Bird& getBird(int bird) const { return birds[bird]; }
+    const std::vector<Pipe>& getPipes() const { return pipes; }
+    int getScore() const { return score; }
+    int getFrames() const { return frames; }
+
+    // Result of a bird once it is dead (or the round hit maxFrames)
+    const GameResult& getResult(int bird) const { return results[bird]; }
+
+private:
+    std::vector<int> topology;
+    int numWeights;
+    std::vector<float> genomes;  // size() * numWeights
+    std::vector<float> scratch;  // two activation rows of the widest layer
+
+    std::vector<Bird> birds;
+    std::vector<GameResult> results;  // framesAlive < 0 while flying
+    std::vector<Pipe> pipes;
+    int alive;
+    int score;
+    int frames;
+    int maxFrames;
+    int pipeSpawnCounter;
+
+    std::mt19937 gen;
+    std::uniform_real_distribution<float> gapSize;
+    std::uniform_real_distribution<float> gapY;
+
+    float forward(const float* genome, const float* features);
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "genome_codec.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GENOME_CODEC_F16C 1
+#endif
+
+static inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// fp32 -> fp16, round to nearest even (overflow -> inf, NaN stays NaN)
+static inline uint16_t floatToHalf(float value) {
+    const uint32_t f32Infinity = 255u << 23;
+    const uint32_t f16Max = (127u + 16u) << 23;
+    const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t bits = floatBits(value);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= f16Max) {
+        half = bits > f32Infinity ? 0x7e00u : 0x7c00u;
+    } else if (bits < (113u << 23)) {
+        // Subnormal half: let the FPU do the rounding shift
+        half = floatBits(bitsFloat(bits) + bitsFloat(denormMagic)) - denormMagic;
+    } else {
+        uint32_t mantissaOdd = (bits >> 13) & 1u;
+        bits += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+        half = bits >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+// fp16 -> fp32 (exact)
+static inline float halfToFloat(uint16_t half) {
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t bits = (half & 0x7fffu) << 13;
+    uint32_t exponent = bits & shiftedExponent;
+    bits += (127u - 15u) << 23;
+    if (exponent == shiftedExponent) {
+        bits += (128u - 16u) << 23;  // inf/NaN
+    } else if (exponent == 0) {
+        bits += 1u << 23;            // zero/subnormal: renormalize
+        bits = floatBits(bitsFloat(bits) - bitsFloat(113u << 23));
+    }
+    return bitsFloat(bits | (static_cast<uint32_t>(half & 0x8000u) << 16));
+}
+
+// fp32 -> bf16, round to nearest even (NaN stays quiet NaN)
+static inline uint16_t floatToBfloat(float value) {
+    uint32_t bits = floatBits(value);
+    uint32_t rounded = (bits + 0x7fffu + ((bits >> 16) & 1u)) >> 16;
+    bool isNan = (bits & 0x7fffffffu) > 0x7f800000u;
+    return static_cast<uint16_t>(isNan ? (bits >> 16) | 0x40u : rounded);
+}
+
+// bf16 -> fp32 (exact)
+static inline float bfloatToFloat(uint16_t value) {
+    return bitsFloat(static_cast<uint32_t>(value) << 16);
+}
+
+#ifdef GENOME_CODEC_F16C
+// 8 conversions per instruction; compiled for F16C regardless of -march
+// and only called when the CPU reports support
+__attribute__((target("avx,f16c")))
+static void encodeHalfF16C(const float* weights, size_t count, uint16_t* out) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(weights + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    for (; i < count; i++) {
+        out[i] = floatToHalf(weights[i]);
+    }
+}
+
+__attribute__((target("avx,f16c")))
+static void decodeHalfF16C(const uint16_t* data, size_t count, float* weights) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm256_storeu_ps(weights + i, _mm256_cvtph_ps(packed));
+    }
+    for (; i < count; i++) {
+        weights[i] = halfToFloat(data[i]);
+    }
+}
+
+static bool hasF16C() {
+    static const bool supported = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+    return supported;
+}
+#endif
+
+size_t genomeBytesPerWeight(GenomePrecision precision) {
+    return precision == GenomePrecision::FP32 ? sizeof(float) : sizeof(uint16_t);
+}
+
+const char* genomePrecisionName(GenomePrecision precision) {
+    switch (precision) {
+        case GenomePrecision::FP16: return "fp16";
+        case GenomePrecision::BF16: return "bf16";
+        default: return "fp32";
+    }
+}
+
+bool parseGenomePrecision(const std::string& name, GenomePrecision& precision) {
+    if (name == "fp32") {
+        precision = GenomePrecision::FP32;
+    } else if (name == "fp16") {
+        precision = GenomePrecision::FP16;
+    } else if (name == "bf16") {
+        precision = GenomePrecision::BF16;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Round weights into the storage format
+void encodeGenome(const float* weights, size_t count, GenomePrecision precision, void* out) {
+    uint16_t* packed = static_cast<uint16_t*>(out);
+    switch (precision) {
+        case GenomePrecision::FP16:
+#ifdef GENOME_CODEC_F16C
+            if (hasF16C()) {
+                encodeHalfF16C(weights, count, packed);
+                break;
+            }
+#endif
+            for (size_t i = 0; i < count; i++) {
+                packed[i] = floatToHalf(weights[i]);
+            }
+            break;
+        case GenomePrecision::BF16:
+            for (size_t i = 0; i < count; i++) {
+                packed[i] = floatToBfloat(weights[i]);
+            }
+            break;
+        default:
+            std::memcpy(out, weights, count * sizeof(float));
+            break;
+    }
+}
+
+// Widen stored weights to fp32
+void decodeGenome(const void* data, size_t count, GenomePrecision precision, float* weights) {
+    const uint16_t* packed = static_cast<const uint16_t*>(data);
+    switch (precision) {
+        case GenomePrecision::FP16:
+#ifdef GENOME_CODEC_F16C
+            if (hasF16C()) {
+                decodeHalfF16C(packed, count, weights);
+                break;
+            }
+#endif
+            for (size_t i = 0; i < count; i++) {
+                weights[i] = halfToFloat(packed[i]);
+            }
+            break;
+        case GenomePrecision::BF16:
+            for (size_t i = 0; i < count; i++) {
+                weights[i] = bfloatToFloat(packed[i]);
+            }
+            break;
+        default:
+            std::memcpy(weights, data, count * sizeof(float));
+            break;
+    }
+}
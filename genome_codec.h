@@ -0,0 +1,29 @@
+#ifndef GENOME_CODEC_H
+#define GENOME_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Storage precision of genomes at rest (population store, saved agents)
+// Networks always compute in fp32; genomes are widened on load and rounded
+// to nearest even on store.
+enum class GenomePrecision : uint32_t {
+    FP32 = 0,
+    FP16 = 1,  // IEEE half: 10-bit mantissa, range +-65504
+    BF16 = 2   // bfloat16: 7-bit mantissa, fp32 range
+};
+
+// Bytes per stored weight
+size_t genomeBytesPerWeight(GenomePrecision precision);
+
+// "fp32" / "fp16" / "bf16"
+const char* genomePrecisionName(GenomePrecision precision);
+bool parseGenomePrecision(const std::string& name, GenomePrecision& precision);
+
+// Convert count weights between fp32 and the storage format
+// Uses F16C for fp16 when the CPU has it; the portable paths are branch-free.
+void encodeGenome(const float* weights, size_t count, GenomePrecision precision, void* out);
+void decodeGenome(const void* data, size_t count, GenomePrecision precision, float* weights);
+
+#endif
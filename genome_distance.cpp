@@ -0,0 +1,138 @@
+#include "genome_distance.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GENOME_DISTANCE_AVX 1
+#endif
+
+// 8-wide float vector (GCC/Clang vector extension; lowered to SSE/AVX/NEON).
+// Helpers take references so no 32-byte vector crosses a function ABI.
+typedef float Vec8 __attribute__((vector_size(32)));
+
+static inline void load8(Vec8& v, const float* p) {
+    std::memcpy(&v, p, sizeof(v));
+}
+
+static inline float sum8(const Vec8& v) {
+    return ((v[0] + v[4]) + (v[1] + v[5])) + ((v[2] + v[6]) + (v[3] + v[7]));
+}
+
+// Register tile: TILE_ROWS x TILE_COLS dot products accumulated at once
+static const int TILE_ROWS = 4;
+static const int TILE_COLS = 2;
+
+// Constructor: zeroed, padded storage
+GenomeMatrix::GenomeMatrix(int rows, int cols)
+    : rows(rows),
+      cols(cols),
+      stride((cols + LANES - 1) / LANES * LANES),
+      data(static_cast<size_t>(rows) * stride, 0.0f),
+      norms(rows, 0.0f) {
+}
+
+// Copy a flat genome into a row
+void GenomeMatrix::setRow(int row, const std::vector<float>& genome) {
+    int count = std::min(cols, static_cast<int>(genome.size()));
+    std::copy(genome.begin(), genome.begin() + count,
+              data.begin() + static_cast<size_t>(row) * stride);
+}
+
+// Copy a row and its norm
+void GenomeMatrix::copyRow(int row, const GenomeMatrix& source, int sourceRow) {
+    std::copy(source.row(sourceRow), source.row(sourceRow) + stride,
+              data.begin() + static_cast<size_t>(row) * stride);
+    norms[row] = source.norm(sourceRow);
+}
+
+// Cache squared norms of every row
+void GenomeMatrix::computeNorms() {
+    for (int r = 0; r < rows; r++) {
+        const float* p = row(r);
+        Vec8 acc = {};
+        for (int k = 0; k < stride; k += LANES) {
+            Vec8 v;
+            load8(v, p + k);
+            acc += v * v;
+        }
+        norms[r] = sum8(acc);
+    }
+}
+
+// Squared distances via |a|^2 + |b|^2 - 2 a.b over a blocked tile. The body
+// is compiled twice (baseline and AVX); both run the same lane-wise adds and
+// multiplies in the same order, so they produce identical distances.
+__attribute__((always_inline))
+static inline void distanceTile(const GenomeMatrix& a, int rowBegin, int rowEnd,
+                                const GenomeMatrix& b, int colBegin, int colEnd,
+                                float* out, int outStride) {
+    const int stride = a.getStride();
+
+    for (int i = rowBegin; i < rowEnd; i += TILE_ROWS) {
+        int numRows = std::min(TILE_ROWS, rowEnd - i);
+        const float* rowPtr[TILE_ROWS];
+        for (int r = 0; r < TILE_ROWS; r++) {
+            // Edge tiles repeat the last valid row; those results are discarded
+            rowPtr[r] = a.row(i + std::min(r, numRows - 1));
+        }
+
+        for (int j = colBegin; j < colEnd; j += TILE_COLS) {
+            int numCols = std::min(TILE_COLS, colEnd - j);
+            const float* colPtr[TILE_COLS];
+            for (int c = 0; c < TILE_COLS; c++) {
+                colPtr[c] = b.row(j + std::min(c, numCols - 1));
+            }
+
+            Vec8 acc[TILE_ROWS][TILE_COLS] = {};
+            for (int k = 0; k < stride; k += GenomeMatrix::LANES) {
+                Vec8 vb[TILE_COLS];
+                for (int c = 0; c < TILE_COLS; c++) {
+                    load8(vb[c], colPtr[c] + k);
+                }
+                for (int r = 0; r < TILE_ROWS; r++) {
+                    Vec8 va;
+                    load8(va, rowPtr[r] + k);
+                    for (int c = 0; c < TILE_COLS; c++) {
+                        acc[r][c] += va * vb[c];
+                    }
+                }
+            }
+
+            for (int r = 0; r < numRows; r++) {
+                float* outRow = out + static_cast<size_t>(i - rowBegin + r) * outStride + (j - colBegin);
+                for (int c = 0; c < numCols; c++) {
+                    float d = a.norm(i + r) + b.norm(j + c) - 2.0f * sum8(acc[r][c]);
+                    outRow[c] = std::max(0.0f, d);
+                }
+            }
+        }
+    }
+}
+
+#ifdef GENOME_DISTANCE_AVX
+// One 256-bit op per Vec8 instead of two 128-bit ones; no FMA, which would
+// round differently from the baseline
+__attribute__((target("avx")))
+static void distanceTileAVX(const GenomeMatrix& a, int rowBegin, int rowEnd,
+                            const GenomeMatrix& b, int colBegin, int colEnd,
+                            float* out, int outStride) {
+    distanceTile(a, rowBegin, rowEnd, b, colBegin, colEnd, out, outStride);
+}
+
+static bool hasAVX() {
+    static const bool supported = __builtin_cpu_supports("avx");
+    return supported;
+}
+#endif
+
+void squaredDistanceTile(const GenomeMatrix& a, int rowBegin, int rowEnd,
+                         const GenomeMatrix& b, int colBegin, int colEnd,
+                         float* out, int outStride) {
+#ifdef GENOME_DISTANCE_AVX
+    if (hasAVX()) {
+        distanceTileAVX(a, rowBegin, rowEnd, b, colBegin, colEnd, out, outStride);
+        return;
+    }
+#endif
+    distanceTile(a, rowBegin, rowEnd, b, colBegin, colEnd, out, outStride);
+}
@@ -0,0 +1,47 @@
+#ifndef GENOME_DISTANCE_H
+#define GENOME_DISTANCE_H
+
+#include <cstddef>
+#include <vector>
+
+// Genomes packed as rows of a matrix for distance computations
+// Rows are zero-padded to a multiple of 8 floats so the kernel never needs
+// a remainder loop; squared norms are cached per row.
+class GenomeMatrix {
+private:
+    int rows;
+    int cols;
+    int stride;
+    std::vector<float> data;
+    std::vector<float> norms;
+
+public:
+    static const int LANES = 8;
+
+    GenomeMatrix(int rows, int cols);
+
+    // Copy a flat genome (e.g. from NeuralNetwork::getWeights) into a row
+    void setRow(int row, const std::vector<float>& genome);
+
+    // Copy one row (and its cached norm) from another matrix with the same cols
+    void copyRow(int row, const GenomeMatrix& source, int sourceRow);
+
+    // Recompute cached squared norms (call after filling rows)
+    void computeNorms();
+
+    const float* row(int row) const { return data.data() + static_cast<size_t>(row) * stride; }
+    float norm(int row) const { return norms[row]; }
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getStride() const { return stride; }
+};
+
+// Squared Euclidean distances between rows [rowBegin, rowEnd) of a and
+// rows [colBegin, colEnd) of b, written to out[(i - rowBegin) * outStride + (j - colBegin)].
+// Blocked 4x2 register tile (4 rows of a by 2 of b), vectorized over the
+// genome dimension; uses AVX when the CPU has it.
+void squaredDistanceTile(const GenomeMatrix& a, int rowBegin, int rowEnd,
+                         const GenomeMatrix& b, int colBegin, int colEnd,
+                         float* out, int outStride);
+
+#endif
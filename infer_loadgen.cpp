@@ -0,0 +1,190 @@
+#include "inference_protocol.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load generator for infer_server
+// Each client thread keeps a fixed number of requests in flight on its own
+// connection (closed loop) and records the round-trip latency of each one.
+
+using Clock = std::chrono::steady_clock;
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -s, --socket PATH         Unix socket path (default: /tmp/flappy-infer.sock)\n";
+    std::cout << "  -c, --clients NUM         Concurrent connections (default: 8)\n";
+    std::cout << "  -n, --requests NUM        Requests per client (default: 100000)\n";
+    std::cout << "  -d, --depth NUM           Requests in flight per client (default: 4)\n";
+    std::cout << "  -m, --models NUM          Spread requests over model ids 0..NUM-1 (default: 1)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+// Write/read exactly size bytes
+static bool sendAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, 0);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool recvAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// One client: returns round-trip latencies in microseconds
+static void runClient(const std::string& socketPath, int requests, int depth, int numModels,
+                      unsigned int seed, std::vector<double>& latencies, bool& failed) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        failed = true;
+        return;
+    }
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> feature(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> model(0, numModels - 1);
+    std::deque<Clock::time_point> inFlight;
+    latencies.reserve(requests);
+
+    int sent = 0;
+    while (static_cast<int>(latencies.size()) < requests) {
+        // Top up the pipeline
+        while (sent < requests && static_cast<int>(inFlight.size()) < depth) {
+            InferenceRequest request;
+            request.model = model(gen);
+            for (float& f : request.features) {
+                f = feature(gen);
+            }
+            inFlight.push_back(Clock::now());
+            if (!sendAll(fd, &request, sizeof(request))) {
+                failed = true;
+                close(fd);
+                return;
+            }
+            sent++;
+        }
+
+        InferenceResponse response;
+        if (!recvAll(fd, &response, sizeof(response))) {
+            failed = true;
+            close(fd);
+            return;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(
+            Clock::now() - inFlight.front()).count());
+        inFlight.pop_front();
+    }
+
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    std::string socketPath = "/tmp/flappy-infer.sock";
+    int numClients = 8;
+    int requestsPerClient = 100000;
+    int depth = 4;
+    int numModels = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-s" || arg == "--socket") {
+            if (i + 1 < argc) {
+                socketPath = argv[++i];
+            }
+        } else if (arg == "-c" || arg == "--clients") {
+            if (i + 1 < argc) {
+                numClients = std::max(1, std::stoi(argv[++i]));
+            }
+        } else if (arg == "-n" || arg == "--requests") {
+            if (i + 1 < argc) {
+                requestsPerClient = std::max(1, std::stoi(argv[++i]));
+            }
+        } else if (arg == "-d" || arg == "--depth") {
+            if (i + 1 < argc) {
+                depth = std::max(1, std::stoi(argv[++i]));
+            }
+        } else if (arg == "-m" || arg == "--models") {
+            if (i + 1 < argc) {
+                numModels = std::max(1, std::stoi(argv[++i]));
+            }
+        }
+    }
+
+    std::cout << "Clients: " << numClients << ", requests/client: " << requestsPerClient
+              << ", in flight/client: " << depth << "\n";
+
+    std::vector<std::vector<double>> latencies(numClients);
+    std::vector<char> failed(numClients, 0);
+    std::vector<std::thread> clients;
+
+    auto start = Clock::now();
+    for (int c = 0; c < numClients; c++) {
+        clients.emplace_back([&, c] {
+            bool clientFailed = false;
+            runClient(socketPath, requestsPerClient, depth, numModels, 1234u + c,
+                      latencies[c], clientFailed);
+            failed[c] = clientFailed;
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (int c = 0; c < numClients; c++) {
+        if (failed[c]) {
+            std::cerr << "Client " << c << " failed (is the server running on " << socketPath << "?)\n";
+        }
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    }
+    if (all.empty()) {
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+
+    auto percentile = [&all](double p) {
+        return all[static_cast<size_t>(p * (all.size() - 1) + 0.5)];
+    };
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Requests: " << all.size() << " in " << std::setprecision(2) << seconds << " s\n";
+    std::cout << std::setprecision(1);
+    std::cout << "Throughput: " << all.size() / seconds << " requests/s\n";
+    std::cout << "Round-trip latency: p50 " << percentile(0.50) << " us, p99 "
+              << percentile(0.99) << " us, max " << all.back() << " us\n";
+    return 0;
+}
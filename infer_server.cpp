@@ -0,0 +1,366 @@
+#include "inference_protocol.h"
+#include "neural_network.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Micro-batching inference server
+// One event loop reads requests from every connection, holds them for at
+// most the latency budget (or until a batch is full), then runs one batched
+// forward pass per model and writes the responses back.
+
+using Clock = std::chrono::steady_clock;
+
+struct Connection {
+    int fd;
+    std::string input;   // bytes received but not yet parsed
+    std::string output;  // bytes waiting to be sent
+};
+
+struct PendingRequest {
+    int connection;       // index into connections (-1 once it has closed)
+    InferenceRequest request;
+    Clock::time_point received;
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void handleSignal(int) {
+    stopRequested = 1;
+}
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " --model FILE [--model FILE ...] [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -m, --model FILE          Saved network to serve (repeat for more; id = order)\n";
+    std::cout << "  -s, --socket PATH         Unix socket path (default: /tmp/flappy-infer.sock)\n";
+    std::cout << "  -b, --max-batch NUM       Largest batch per forward pass (default: 256)\n";
+    std::cout << "  -l, --latency-us NUM      Max time a request waits for a batch (default: 200)\n";
+    std::cout << "  -r, --report SECONDS      Statistics interval (default: 5)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+// Set a socket to non-blocking mode
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// Wait for I/O for at most timeout. ppoll takes it to the nanosecond; plain
+// poll rounds up to a whole millisecond, so a sub-millisecond budget can
+// add up to 1 ms of latency there instead of spinning on a zero timeout.
+static void waitForIO(std::vector<pollfd>& fds, std::chrono::nanoseconds timeout) {
+    long long ns = std::max<long long>(0, timeout.count());
+#ifdef __linux__
+    timespec limit;
+    limit.tv_sec = static_cast<time_t>(ns / 1000000000);
+    limit.tv_nsec = static_cast<long>(ns % 1000000000);
+    ppoll(fds.data(), fds.size(), &limit, nullptr);
+#else
+    poll(fds.data(), fds.size(), static_cast<int>((ns + 999999) / 1000000));
+#endif
+}
+
+// Percentile of a sorted vector
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> modelFiles;
+    std::string socketPath = "/tmp/flappy-infer.sock";
+    int maxBatch = 256;
+    int latencyBudgetUs = 200;
+    int reportSeconds = 5;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-m" || arg == "--model") {
+            if (i + 1 < argc) {
+                modelFiles.push_back(argv[++i]);
+            }
+        } else if (arg == "-s" || arg == "--socket") {
+            if (i + 1 < argc) {
+                socketPath = argv[++i];
+            }
+        } else if (arg == "-b" || arg == "--max-batch") {
+            if (i + 1 < argc) {
+                maxBatch = std::max(1, std::stoi(argv[++i]));
+            }
+        } else if (arg == "-l" || arg == "--latency-us") {
+            if (i + 1 < argc) {
+                latencyBudgetUs = std::max(0, std::stoi(argv[++i]));
+            }
+        } else if (arg == "-r" || arg == "--report") {
+            if (i + 1 < argc) {
+                reportSeconds = std::max(1, std::stoi(argv[++i]));
+            }
+        }
+    }
+
+    if (modelFiles.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Load models
+    std::vector<std::unique_ptr<NeuralNetwork>> models;
+    for (const auto& file : modelFiles) {
+        auto model = NeuralNetwork::load(file);
+        if (!model || model->getTopology()[0] != INFERENCE_FEATURES ||
+            model->getTopology().back() != 1) {
+            std::cerr << "Error: could not load a 5-input, 1-output network from " << file << "\n";
+            return 1;
+        }
+        std::cout << "Model " << models.size() << ": " << file << "\n";
+        models.push_back(std::move(model));
+    }
+
+    // Listen on the Unix socket
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (listenFd < 0 || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: bad socket path " << socketPath << "\n";
+        return 1;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, 128) < 0) {
+        std::cerr << "Error: could not listen on " << socketPath << "\n";
+        return 1;
+    }
+    setNonBlocking(listenFd);
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+#ifdef __linux__
+    // Wake up on the budget, not up to the default 50 us timer slack after it
+    prctl(PR_SET_TIMERSLACK, 1UL);
+#endif
+
+    std::cout << "Listening on " << socketPath << " (max batch " << maxBatch
+              << ", latency budget " << latencyBudgetUs << " us)\n";
+
+    std::vector<Connection> connections;
+    std::vector<PendingRequest> pending;
+    std::vector<pollfd> pollFds;
+
+    // Batch scratch, grouped per model
+    std::vector<std::vector<float>> batchInputs(models.size());
+    std::vector<std::vector<int>> batchMembers(models.size());
+    std::vector<float> batchOutputs;
+
+    // Statistics for the current report interval
+    std::vector<double> latencies;
+    long long batches = 0;
+    auto reportStart = Clock::now();
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    while (!stopRequested) {
+        // Wait for I/O, but never past the oldest request's deadline
+        std::chrono::nanoseconds timeout = std::chrono::milliseconds(100);
+        if (!pending.empty()) {
+            auto deadline = pending.front().received + std::chrono::microseconds(latencyBudgetUs);
+            timeout = deadline - Clock::now();
+        }
+
+        pollFds.clear();
+        pollFds.push_back({listenFd, POLLIN, 0});
+        for (const auto& connection : connections) {
+            short events = POLLIN;
+            if (!connection.output.empty()) {
+                events |= POLLOUT;
+            }
+            pollFds.push_back({connection.fd, events, 0});
+        }
+        waitForIO(pollFds, timeout);
+
+        // Accept new clients
+        if (pollFds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listenFd, nullptr, nullptr)) >= 0) {
+                setNonBlocking(fd);
+                connections.push_back({fd, "", ""});
+            }
+        }
+
+        // Read requests and flush pending responses
+        auto now = Clock::now();
+        for (size_t c = 0; c + 1 < pollFds.size() && c < connections.size(); c++) {
+            Connection& connection = connections[c];
+            short revents = pollFds[c + 1].revents;
+
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[16384];
+                ssize_t n;
+                while ((n = recv(connection.fd, buffer, sizeof(buffer), 0)) > 0) {
+                    connection.input.append(buffer, n);
+                }
+                bool closed = n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+
+                size_t offset = 0;
+                while (connection.input.size() - offset >= sizeof(InferenceRequest)) {
+                    PendingRequest request;
+                    request.connection = static_cast<int>(c);
+                    std::memcpy(&request.request, connection.input.data() + offset, sizeof(InferenceRequest));
+                    request.received = now;
+                    pending.push_back(request);
+                    offset += sizeof(InferenceRequest);
+                }
+                connection.input.erase(0, offset);
+
+                if (closed) {
+                    close(connection.fd);
+                    connection.fd = -1;
+                    continue;
+                }
+            }
+
+            if ((revents & POLLOUT) && !connection.output.empty()) {
+                ssize_t n = send(connection.fd, connection.output.data(), connection.output.size(), 0);
+                if (n > 0) {
+                    connection.output.erase(0, n);
+                }
+            }
+        }
+
+        // Run batches while one is full or the oldest request is due
+        now = Clock::now();
+        while (!pending.empty() &&
+               (static_cast<int>(pending.size()) >= maxBatch ||
+                now - pending.front().received >= std::chrono::microseconds(latencyBudgetUs))) {
+            int batchSize = std::min(maxBatch, static_cast<int>(pending.size()));
+
+            for (size_t m = 0; m < models.size(); m++) {
+                batchInputs[m].clear();
+                batchMembers[m].clear();
+            }
+            std::vector<InferenceResponse> responses(batchSize);
+            for (int i = 0; i < batchSize; i++) {
+                uint32_t model = pending[i].request.model;
+                if (model >= models.size()) {
+                    responses[i] = {0.0f, INFERENCE_BAD_MODEL};
+                    continue;
+                }
+                batchInputs[model].insert(batchInputs[model].end(), pending[i].request.features,
+                                          pending[i].request.features + INFERENCE_FEATURES);
+                batchMembers[model].push_back(i);
+            }
+
+            // One vectorized forward pass per model present in the batch
+            for (size_t m = 0; m < models.size(); m++) {
+                int count = static_cast<int>(batchMembers[m].size());
+                if (count == 0) {
+                    continue;
+                }
+                batchOutputs.resize(count);
+                models[m]->forwardBatch(batchInputs[m].data(), count, batchOutputs.data());
+                for (int k = 0; k < count; k++) {
+                    responses[batchMembers[m][k]] = {batchOutputs[k], batchOutputs[k] > 0.5f ? 1u : 0u};
+                }
+            }
+
+            // Queue responses (in arrival order, so per-connection order is kept)
+            auto done = Clock::now();
+            for (int i = 0; i < batchSize; i++) {
+                int c = pending[i].connection;
+                if (c >= 0 && connections[c].fd >= 0) {
+                    connections[c].output.append(reinterpret_cast<const char*>(&responses[i]),
+                                                 sizeof(InferenceResponse));
+                }
+                latencies.push_back(std::chrono::duration<double, std::micro>(
+                    done - pending[i].received).count());
+            }
+            pending.erase(pending.begin(), pending.begin() + batchSize);
+            batches++;
+            now = Clock::now();
+        }
+
+        // Try to send right away instead of waiting for the next poll
+        for (auto& connection : connections) {
+            if (connection.fd >= 0 && !connection.output.empty()) {
+                ssize_t n = send(connection.fd, connection.output.data(), connection.output.size(), 0);
+                if (n > 0) {
+                    connection.output.erase(0, n);
+                }
+            }
+        }
+
+        // Drop closed connections and renumber the pending requests; those of
+        // a closed connection are still answered, into the void
+        if (std::any_of(connections.begin(), connections.end(),
+                        [](const Connection& c) { return c.fd < 0; })) {
+            std::vector<int> renumber(connections.size(), -1);
+            size_t kept = 0;
+            for (size_t c = 0; c < connections.size(); c++) {
+                if (connections[c].fd >= 0) {
+                    renumber[c] = static_cast<int>(kept);
+                    if (kept != c) {
+                        connections[kept] = std::move(connections[c]);
+                    }
+                    kept++;
+                }
+            }
+            connections.resize(kept);
+            for (auto& request : pending) {
+                if (request.connection >= 0) {
+                    request.connection = renumber[request.connection];
+                }
+            }
+        }
+
+        // Periodic statistics
+        double elapsed = std::chrono::duration<double>(Clock::now() - reportStart).count();
+        if (elapsed >= reportSeconds) {
+            if (!latencies.empty()) {
+                std::sort(latencies.begin(), latencies.end());
+                std::cout << "requests/s: " << std::setw(10) << latencies.size() / elapsed
+                          << "  p50: " << std::setw(7) << percentile(latencies, 0.50) << " us"
+                          << "  p99: " << std::setw(7) << percentile(latencies, 0.99) << " us"
+                          << "  avg batch: " << std::setw(6)
+                          << static_cast<double>(latencies.size()) / batches
+                          << "  clients: " << connections.size() << "\n";
+            }
+            latencies.clear();
+            batches = 0;
+            reportStart = Clock::now();
+        }
+    }
+
+    for (const auto& connection : connections) {
+        if (connection.fd >= 0) {
+            close(connection.fd);
+        }
+    }
+    close(listenFd);
+    unlink(socketPath.c_str());
+    std::cout << "\nServer stopped\n";
+    return 0;
+}
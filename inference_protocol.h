@@ -0,0 +1,25 @@
+#ifndef INFERENCE_PROTOCOL_H
+#define INFERENCE_PROTOCOL_H
+
+#include <cstdint>
+
+// Wire format of the inference server (Unix domain socket, native byte order)
+// A client may pipeline any number of requests on one connection; responses
+// come back in request order.
+
+// Number of features per request (extractFeatures layout)
+const int INFERENCE_FEATURES = 5;
+
+struct InferenceRequest {
+    uint32_t model;                        // index of the model (order of --model options)
+    float features[INFERENCE_FEATURES];
+};
+
+struct InferenceResponse {
+    float output;   // network output (0-1)
+    uint32_t flap;  // 1 if output > 0.5, 0 otherwise; 0xFFFFFFFF for an unknown model
+};
+
+const uint32_t INFERENCE_BAD_MODEL = 0xFFFFFFFFu;
+
+#endif
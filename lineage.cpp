@@ -0,0 +1,114 @@
+#include "lineage_log.h"
+#include "neural_network.h"
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Inspect a lineage log written by train --lineage-log: summary, the
+// ancestry of a genome, and reconstruction of any genome into a model file.
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " -l LOG [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -l, --log FILE            Lineage log (from train --lineage-log)\n";
+    std::cout << "  -i, --id NUM              Genome to inspect (train prints the best agent's id)\n";
+    std::cout << "  -a, --ancestry            Print the first-parent line of --id back to the start\n";
+    std::cout << "  -o, --output FILE         Rebuild --id and save it as a model\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string logFile = "";
+    std::string outputFile = "";
+    uint64_t id = NO_PARENT;
+    bool ancestry = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-l" || arg == "--log") {
+            if (i + 1 < argc) {
+                logFile = argv[++i];
+            }
+        } else if (arg == "-i" || arg == "--id") {
+            if (i + 1 < argc) {
+                id = std::stoull(argv[++i]);
+            }
+        } else if (arg == "-a" || arg == "--ancestry") {
+            ancestry = true;
+        } else if (arg == "-o" || arg == "--output") {
+            if (i + 1 < argc) {
+                outputFile = argv[++i];
+            }
+        }
+    }
+
+    if (logFile.empty() || ((ancestry || !outputFile.empty()) && id == NO_PARENT)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    LineageReader reader;
+    if (!reader.open(logFile)) {
+        std::cerr << "Error: could not read lineage log " << logFile << "\n";
+        return 1;
+    }
+
+    std::cout << "Lineage log " << logFile << ": " << reader.getNumRecords() << " genomes ("
+              << reader.getNumKeyframes() << " keyframes), " << reader.getNumWeights()
+              << " weights, topology ";
+    for (size_t i = 0; i < reader.getTopology().size(); i++) {
+        std::cout << (i > 0 ? "-" : "") << reader.getTopology()[i];
+    }
+    std::cout << "\n";
+    if (id == NO_PARENT) {
+        return 0;
+    }
+
+    LineageRecord record;
+    if (!reader.getRecord(id, record)) {
+        std::cerr << "Error: genome " << id << " is not in the log\n";
+        return 1;
+    }
+
+    // Walk parent1 back to a genome without parents
+    if (ancestry) {
+        std::cout << "\nGeneration |       Id |  Parent 2 | Record | Mutations\n";
+        std::cout << "-----------|----------|-----------|--------|----------\n";
+        uint64_t current = id;
+        while (current != NO_PARENT && reader.getRecord(current, record)) {
+            std::cout << std::setw(10) << record.generation << " | " << std::setw(8) << current << " | ";
+            if (record.parent2 == NO_PARENT) {
+                std::cout << std::setw(9) << "-";
+            } else {
+                std::cout << std::setw(9) << record.parent2;
+            }
+            std::cout << " | " << std::setw(6)
+                      << (record.kind == LineageRecord::KEYFRAME ? "full" : "delta") << " | ";
+            if (record.kind == LineageRecord::KEYFRAME) {
+                std::cout << std::setw(9) << "-" << "\n";
+            } else {
+                std::cout << std::setw(9) << record.numDeltas << "\n";
+            }
+            current = record.parent1;
+        }
+    }
+
+    if (!outputFile.empty()) {
+        std::vector<float> genome;
+        if (!reader.reconstruct(id, genome)) {
+            std::cerr << "Error: could not rebuild genome " << id << " (missing ancestor)\n";
+            return 1;
+        }
+        NeuralNetwork network(reader.getTopology(), genome);
+        if (!network.save(outputFile, reader.getPrecision())) {
+            std::cerr << "Error: could not write " << outputFile << "\n";
+            return 1;
+        }
+        std::cout << "Genome " << id << " rebuilt and saved to " << outputFile << "\n";
+    }
+    return 0;
+}
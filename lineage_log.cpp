@@ -0,0 +1,257 @@
+#include "lineage_log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char LINEAGE_MAGIC[4] = {'F', 'L', 'I', 'N'};
+const uint32_t LINEAGE_VERSION = 1;
+const int MAX_LAYERS = 16;
+
+struct LineageFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numWeights;
+    uint32_t numLayers;
+    int32_t topology[MAX_LAYERS];
+    uint32_t precision;  // GenomePrecision of the population the genomes lived in
+    uint32_t keyframeInterval;
+};
+
+template <typename T>
+void appendBytes(std::string& out, const T* data, size_t count) {
+    out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+} // namespace
+
+LineageLog::LineageLog()
+    : file(nullptr),
+      keyframeInterval(0),
+      maxPendingBytes(64 << 20),
+      pendingBytes(0),
+      stopping(false),
+      recordsWritten(0),
+      bytesWritten(0) {
+}
+
+LineageLog::~LineageLog() {
+    close();
+}
+
+// Create the file and start the writer thread
+bool LineageLog::open(const std::string& filename, const std::vector<int>& topology,
+                      int numWeights, GenomePrecision precision, int keyframeInterval) {
+    close();
+    if (topology.size() > static_cast<size_t>(MAX_LAYERS)) {
+        return false;
+    }
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    // Large stdio buffer: the writer thread issues few, big writes
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    LineageFileHeader header = {};
+    std::memcpy(header.magic, LINEAGE_MAGIC, sizeof(header.magic));
+    header.version = LINEAGE_VERSION;
+    header.numWeights = numWeights;
+    header.numLayers = static_cast<uint32_t>(topology.size());
+    std::copy(topology.begin(), topology.end(), header.topology);
+    header.precision = static_cast<uint32_t>(precision);
+    header.keyframeInterval = std::max(0, keyframeInterval);
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    this->keyframeInterval = header.keyframeInterval;
+    stopping = false;
+    recordsWritten = 0;
+    bytesWritten = sizeof(header);
+    writer = std::thread(&LineageLog::writerLoop, this);
+    return true;
+}
+
+// Drain the queue, stop the writer and close the file
+void LineageLog::close() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeWriter.notify_one();
+        writer.join();
+    }
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+// Hand a buffer of records to the writer
+void LineageLog::append(std::string&& records, uint64_t count) {
+    if (!file || records.empty()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeProducer.wait(lock, [this]() { return pendingBytes < maxPendingBytes; });
+    pendingBytes += records.size();
+    pending.push_back(std::move(records));
+    recordsWritten += count;
+    lock.unlock();
+    wakeWriter.notify_one();
+}
+
+// Write queued buffers until close()
+void LineageLog::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWriter.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            break;  // stopping and drained
+        }
+        std::string records = std::move(pending.front());
+        pending.pop_front();
+
+        lock.unlock();
+        std::fwrite(records.data(), 1, records.size(), file);
+        lock.lock();
+
+        pendingBytes -= records.size();
+        bytesWritten += records.size();
+        wakeProducer.notify_all();
+    }
+    std::fflush(file);
+}
+
+// Full genome record
+void LineageLog::encodeKeyframe(std::string& out, uint64_t id, uint64_t parent1,
+                                uint64_t parent2, uint32_t generation,
+                                const std::vector<float>& genome) {
+    LineageRecord record = {id, parent1, parent2, generation, LineageRecord::KEYFRAME, 0, 0};
+    appendBytes(out, &record, 1);
+    appendBytes(out, genome.data(), genome.size());
+}
+
+// Crossover mask and mutation deltas relative to the parents
+void LineageLog::encodeDelta(std::string& out, uint64_t id, uint64_t parent1, uint64_t parent2,
+                             uint32_t generation, const std::vector<uint64_t>& mask,
+                             const std::vector<WeightDelta>& deltas) {
+    LineageRecord record = {id, parent1, parent2, generation, LineageRecord::DELTA,
+                            static_cast<uint32_t>(mask.size()),
+                            static_cast<uint32_t>(deltas.size())};
+    appendBytes(out, &record, 1);
+    appendBytes(out, mask.data(), mask.size());
+    appendBytes(out, deltas.data(), deltas.size());
+}
+
+// Read the header and index every record by id
+bool LineageReader::open(const std::string& filename) {
+    file.open(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    LineageFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LINEAGE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != LINEAGE_VERSION || header.numLayers > static_cast<uint32_t>(MAX_LAYERS)) {
+        return false;
+    }
+    numWeights = header.numWeights;
+    precision = static_cast<GenomePrecision>(header.precision);
+    topology.assign(header.topology, header.topology + header.numLayers);
+
+    // A record cut short by an interrupted run ends the index
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    uint64_t offset = sizeof(header);
+    LineageRecord record;
+    while (offset + sizeof(record) <= fileSize) {
+        file.seekg(static_cast<std::streamoff>(offset));
+        if (!file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            break;
+        }
+        uint64_t payload = record.kind == LineageRecord::KEYFRAME
+            ? static_cast<uint64_t>(numWeights) * sizeof(float)
+            : record.numMaskWords * sizeof(uint64_t) + record.numDeltas * sizeof(WeightDelta);
+        if (offset + sizeof(record) + payload > fileSize) {
+            break;
+        }
+        offsets[record.id] = offset;
+        numKeyframes += record.kind == LineageRecord::KEYFRAME;
+        offset += sizeof(record) + payload;
+    }
+    file.clear();
+    return true;
+}
+
+bool LineageReader::getRecord(uint64_t id, LineageRecord& record) const {
+    auto it = offsets.find(id);
+    if (it == offsets.end()) {
+        return false;
+    }
+    file.seekg(static_cast<std::streamoff>(it->second));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&record), sizeof(record)));
+}
+
+// Replay a record on top of its (recursively rebuilt) parents
+bool LineageReader::reconstruct(uint64_t id, std::vector<float>& genome) {
+    auto cached = genomes.find(id);
+    if (cached != genomes.end()) {
+        genome = cached->second;
+        return true;
+    }
+
+    LineageRecord record;
+    if (!getRecord(id, record)) {
+        return false;
+    }
+
+    if (record.kind == LineageRecord::KEYFRAME) {
+        genome.resize(numWeights);
+        if (!file.read(reinterpret_cast<char*>(genome.data()), numWeights * sizeof(float))) {
+            return false;
+        }
+    } else {
+        std::vector<uint64_t> mask(record.numMaskWords);
+        std::vector<WeightDelta> deltas(record.numDeltas);
+        file.read(reinterpret_cast<char*>(mask.data()), mask.size() * sizeof(uint64_t));
+        file.read(reinterpret_cast<char*>(deltas.data()), deltas.size() * sizeof(WeightDelta));
+        if (!file) {
+            return false;
+        }
+
+        // Parents always have smaller ids, so the recursion terminates
+        std::vector<float> other;
+        if (record.parent1 >= id || !reconstruct(record.parent1, genome)) {
+            return false;
+        }
+        if (!mask.empty()) {
+            if (record.parent2 >= id || !reconstruct(record.parent2, other)) {
+                return false;
+            }
+            for (int i = 0; i < numWeights; i++) {
+                if (mask[i / 64] >> (i % 64) & 1) {
+                    genome[i] = other[i];
+                }
+            }
+        }
+        for (const auto& delta : deltas) {
+            if (delta.index < genome.size()) {
+                genome[delta.index] += delta.delta;
+            }
+        }
+    }
+
+    // Round to the population's storage precision, as the store did
+    if (precision != GenomePrecision::FP32) {
+        std::vector<unsigned char> packed(numWeights * genomeBytesPerWeight(precision));
+        encodeGenome(genome.data(), numWeights, precision, packed.data());
+        decodeGenome(packed.data(), numWeights, precision, genome.data());
+    }
+    genomes[id] = genome;
+    return true;
+}
@@ -0,0 +1,125 @@
+#ifndef LINEAGE_LOG_H
+#define LINEAGE_LOG_H
+
+#include "genome_codec.h"
+#include "neural_network.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Append-only log of every genome produced during training
+// Each genome is stored as the way it was made from its parents: the
+// crossover mask (one bit per gene) and the sparse mutation deltas. Every
+// keyframeInterval generations children are stored in full instead, so
+// rebuilding a genome replays at most that many generations of ancestors.
+//
+// File layout: LineageFileHeader, then LineageRecord entries, each followed by
+//   keyframe: numWeights floats
+//   delta:    numMaskWords uint64 mask words, then numDeltas WeightDelta
+// A delta record without mask words is a copy of parent1 plus its deltas.
+
+const uint64_t NO_PARENT = ~uint64_t(0);
+
+struct LineageRecord {
+    enum Kind : uint32_t { KEYFRAME = 0, DELTA = 1 };
+
+    uint64_t id;
+    uint64_t parent1;
+    uint64_t parent2;
+    uint32_t generation;
+    uint32_t kind;
+    uint32_t numMaskWords;
+    uint32_t numDeltas;
+};
+
+// Writer: records are encoded by the caller (from any thread) into a
+// buffer and handed over with append(); a background thread writes them
+class LineageLog {
+public:
+    LineageLog();
+    ~LineageLog();
+
+    LineageLog(const LineageLog&) = delete;
+    LineageLog& operator=(const LineageLog&) = delete;
+
+    // Create the log; keyframeInterval 0 = only the initial population in full
+    bool open(const std::string& filename, const std::vector<int>& topology, int numWeights,
+              GenomePrecision precision, int keyframeInterval);
+
+    // Flush everything and stop the writer thread
+    void close();
+
+    // Queue encoded records for writing; only blocks if more than
+    // maxPendingBytes are already waiting
+    void append(std::string&& records, uint64_t count);
+
+    // Whether children bred for this generation are stored in full
+    bool isKeyframe(uint32_t generation) const {
+        return keyframeInterval > 0 && generation % keyframeInterval == 0;
+    }
+
+    // Encode one record into out (thread-safe, no shared state)
+    static void encodeKeyframe(std::string& out, uint64_t id, uint64_t parent1, uint64_t parent2,
+                               uint32_t generation, const std::vector<float>& genome);
+    static void encodeDelta(std::string& out, uint64_t id, uint64_t parent1, uint64_t parent2,
+                            uint32_t generation, const std::vector<uint64_t>& mask,
+                            const std::vector<WeightDelta>& deltas);
+
+    uint64_t getRecordsWritten() const { return recordsWritten; }
+    uint64_t getBytesWritten() const { return bytesWritten; }
+
+private:
+    FILE* file;
+    int keyframeInterval;
+    size_t maxPendingBytes;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable wakeProducer;
+    std::deque<std::string> pending;
+    size_t pendingBytes;
+    bool stopping;
+
+    uint64_t recordsWritten;
+    uint64_t bytesWritten;
+
+    void writerLoop();
+};
+
+// Reader: indexes a log and rebuilds any genome by replaying its lineage
+class LineageReader {
+public:
+    bool open(const std::string& filename);
+
+    const std::vector<int>& getTopology() const { return topology; }
+    int getNumWeights() const { return numWeights; }
+    GenomePrecision getPrecision() const { return precision; }
+    size_t getNumRecords() const { return offsets.size(); }
+    uint64_t getNumKeyframes() const { return numKeyframes; }
+
+    // Header of record id; false if the id is not in the log
+    bool getRecord(uint64_t id, LineageRecord& record) const;
+
+    // Rebuild the genome of id (flat layout of NeuralNetwork::getWeights),
+    // exactly as it was stored in the population
+    bool reconstruct(uint64_t id, std::vector<float>& genome);
+
+private:
+    mutable std::ifstream file;
+    std::vector<int> topology;
+    int numWeights = 0;
+    GenomePrecision precision = GenomePrecision::FP32;
+    uint64_t numKeyframes = 0;
+    std::unordered_map<uint64_t, uint64_t> offsets;  // id -> record offset
+    std::unordered_map<uint64_t, std::vector<float>> genomes;  // rebuilt so far
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "live_feed.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace {
+
+const char FEED_MAGIC[4] = {'F', 'L', 'I', 'V'};
+const uint32_t FEED_VERSION = 1;
+const int MAX_LAYERS = 16;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the live feed needs lock-free 64-bit atomics in shared memory");
+
+struct FeedHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t session;  // distinguishes training runs that reuse the name
+    uint32_t numSlots;
+    uint32_t numWeights;
+    uint32_t slotBytes;
+    uint32_t numLayers;
+    int32_t topology[MAX_LAYERS];
+    std::atomic<uint64_t> published;  // generations published so far
+};
+
+// Slot k % numSlots holds entry k; sequence is 2k + 1 while it is being
+// written and 2k + 2 once complete. The genome follows the slot.
+struct alignas(64) FeedSlot {
+    std::atomic<uint64_t> sequence;
+    LiveFeedStats stats;
+};
+
+size_t headerBytes() {
+    return (sizeof(FeedHeader) + 63) / 64 * 64;
+}
+
+size_t slotBytes(int numWeights) {
+    return (sizeof(FeedSlot) + numWeights * sizeof(float) + 63) / 64 * 64;
+}
+
+} // namespace
+
+LiveFeedWriter::LiveFeedWriter() : base(nullptr), mappedSize(0), published(0) {
+}
+
+LiveFeedWriter::~LiveFeedWriter() {
+    close();
+}
+
+// Create the shared memory object and write its header
+bool LiveFeedWriter::create(const std::string& name, const std::vector<int>& topology,
+                            int numWeights, int numSlots) {
+    close();
+    if (topology.size() > static_cast<size_t>(MAX_LAYERS) || numSlots < 1) {
+        return false;
+    }
+    size_t size = headerBytes() + static_cast<size_t>(numSlots) * slotBytes(numWeights);
+
+    // A fresh object every run: readers of an old one see it go stale
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    this->name = name;
+    base = static_cast<unsigned char*>(mapping);
+    mappedSize = size;
+    published = 0;
+
+    // ftruncate zero-fills, so every slot starts at sequence 0 (never valid)
+    FeedHeader* header = new (base) FeedHeader;
+    header->version = FEED_VERSION;
+    header->session = static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count()) ^ static_cast<uint64_t>(getpid());
+    header->numSlots = numSlots;
+    header->numWeights = numWeights;
+    header->slotBytes = static_cast<uint32_t>(slotBytes(numWeights));
+    header->numLayers = static_cast<uint32_t>(topology.size());
+    std::copy(topology.begin(), topology.end(), header->topology);
+    header->published.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < numSlots; i++) {
+        new (base + headerBytes() + static_cast<size_t>(i) * header->slotBytes) FeedSlot{};
+    }
+
+    // Magic last: a reader that sees it sees a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, FEED_MAGIC, sizeof(header->magic));
+    return true;
+}
+
+// Seqlock write of the next slot
+void LiveFeedWriter::publish(const LiveFeedStats& stats, const std::vector<float>& bestGenome) {
+    if (!base) {
+        return;
+    }
+    FeedHeader* header = reinterpret_cast<FeedHeader*>(base);
+    uint64_t entry = published++;
+    FeedSlot* slot = reinterpret_cast<FeedSlot*>(
+        base + headerBytes() + (entry % header->numSlots) * header->slotBytes);
+
+    slot->sequence.store(2 * entry + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->stats = stats;
+    size_t count = std::min<size_t>(bestGenome.size(), header->numWeights);
+    std::memcpy(reinterpret_cast<unsigned char*>(slot) + sizeof(FeedSlot), bestGenome.data(),
+                count * sizeof(float));
+
+    slot->sequence.store(2 * entry + 2, std::memory_order_release);
+    header->published.store(entry + 1, std::memory_order_release);
+}
+
+void LiveFeedWriter::close() {
+    if (base) {
+        munmap(base, mappedSize);
+        shm_unlink(name.c_str());
+        base = nullptr;
+    }
+}
+
+LiveFeedReader::LiveFeedReader() : base(nullptr), mappedSize(0), session(0), nextEntry(0) {
+}
+
+LiveFeedReader::~LiveFeedReader() {
+    detach();
+}
+
+void LiveFeedReader::detach() {
+    if (base) {
+        munmap(const_cast<unsigned char*>(base), mappedSize);
+        base = nullptr;
+    }
+}
+
+// Map an existing feed read-only
+bool LiveFeedReader::attach(const std::string& name) {
+    detach();
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= headerBytes()) {
+        mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    base = static_cast<const unsigned char*>(mapping);
+    mappedSize = info.st_size;
+
+    const FeedHeader* header = reinterpret_cast<const FeedHeader*>(base);
+    bool valid = std::memcmp(header->magic, FEED_MAGIC, sizeof(header->magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || header->version != FEED_VERSION || header->numLayers > MAX_LAYERS ||
+        headerBytes() + static_cast<size_t>(header->numSlots) * header->slotBytes > mappedSize) {
+        detach();
+        return false;
+    }
+    session = header->session;
+    topology.assign(header->topology, header->topology + header->numLayers);
+    nextEntry = 0;
+    return true;
+}
+
+// Compare the session of the object currently behind name with ours
+bool LiveFeedReader::isStale(const std::string& name) const {
+    if (!base) {
+        return true;
+    }
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;  // trainer finished: keep showing what we have
+    }
+    FeedHeader current;
+    bool changed = pread(fd, &current, sizeof(current), 0) == static_cast<ssize_t>(sizeof(current)) &&
+                   std::memcmp(current.magic, FEED_MAGIC, sizeof(current.magic)) == 0 &&
+                   current.session != session;
+    ::close(fd);
+    return changed;
+}
+
+// Seqlock read of every entry since the last poll that is still in the ring
+int LiveFeedReader::poll(std::vector<LiveFeedStats>& history, std::vector<float>& genome) {
+    if (!base) {
+        return 0;
+    }
+    const FeedHeader* header = reinterpret_cast<const FeedHeader*>(base);
+    uint64_t published = header->published.load(std::memory_order_acquire);
+    uint64_t first = std::max(nextEntry, published > header->numSlots ? published - header->numSlots : 0);
+
+    std::vector<float> copy(header->numWeights);
+    int appended = 0;
+    for (uint64_t entry = first; entry < published; entry++) {
+        const FeedSlot* slot = reinterpret_cast<const FeedSlot*>(
+            base + headerBytes() + (entry % header->numSlots) * header->slotBytes);
+
+        uint64_t before = slot->sequence.load(std::memory_order_acquire);
+        if (before != 2 * entry + 2) {
+            continue;  // already being overwritten
+        }
+        LiveFeedStats stats = slot->stats;
+        bool newest = entry + 1 == published;
+        if (newest) {
+            std::memcpy(copy.data(), reinterpret_cast<const unsigned char*>(slot) + sizeof(FeedSlot),
+                        copy.size() * sizeof(float));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != before) {
+            continue;  // torn copy
+        }
+
+        history.push_back(stats);
+        appended++;
+        if (newest) {
+            genome = copy;
+        }
+    }
+    nextEntry = published;
+    return appended;
+}
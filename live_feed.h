@@ -0,0 +1,83 @@
+#ifndef LIVE_FEED_H
+#define LIVE_FEED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Live feed from the trainer to viewers through POSIX shared memory
+// The trainer is the only writer: each generation it fills the next slot of
+// a ring with the generation's statistics and best genome, guarded by a
+// per-slot sequence number (odd while the slot is being written). Readers
+// copy a slot and keep it only if the sequence was even and unchanged
+// around the copy, so the writer never waits for, or knows about, readers;
+// a reader that falls more than a ring behind just misses generations.
+
+// Statistics of one generation
+struct LiveFeedStats {
+    uint64_t generation;
+    float best;
+    float average;
+    float worst;
+    float seconds;  // wall time of the generation
+};
+
+class LiveFeedWriter {
+public:
+    LiveFeedWriter();
+    ~LiveFeedWriter();
+
+    LiveFeedWriter(const LiveFeedWriter&) = delete;
+    LiveFeedWriter& operator=(const LiveFeedWriter&) = delete;
+
+    // Create (or replace) the shared memory object name, e.g. "/flappy-live"
+    bool create(const std::string& name, const std::vector<int>& topology, int numWeights,
+                int numSlots = 256);
+
+    // Publish a generation; never blocks
+    void publish(const LiveFeedStats& stats, const std::vector<float>& bestGenome);
+
+    // Unmap and remove the shared memory object
+    void close();
+
+private:
+    std::string name;
+    unsigned char* base;
+    size_t mappedSize;
+    uint64_t published;
+};
+
+class LiveFeedReader {
+public:
+    LiveFeedReader();
+    ~LiveFeedReader();
+
+    LiveFeedReader(const LiveFeedReader&) = delete;
+    LiveFeedReader& operator=(const LiveFeedReader&) = delete;
+
+    // Map the feed read-only; false if no trainer has created it (yet)
+    bool attach(const std::string& name);
+
+    // True if name now belongs to another training run than the one mapped
+    bool isStale(const std::string& name) const;
+
+    // Append generations published since the last poll to history (oldest
+    // first, overwritten ones skipped); genome receives the best genome of
+    // the newest one. Returns the number of generations appended.
+    int poll(std::vector<LiveFeedStats>& history, std::vector<float>& genome);
+
+    bool isAttached() const { return base != nullptr; }
+    const std::vector<int>& getTopology() const { return topology; }
+
+private:
+    const unsigned char* base;
+    size_t mappedSize;
+    uint64_t session;
+    uint64_t nextEntry;
+    std::vector<int> topology;
+
+    void detach();
+};
+
+#endif
@@ -1,16 +1,74 @@
 #include <iostream>
 #include <random>
+#include <string>
 #include <vector>
 #include <algorithm>
 #include <SFML/Graphics.hpp>
 
 #include "game_types.h"
 #include "renderer.h"
-
-int main() {
+#include "spectator.h"
+
+#ifdef FLAPPY_AUTOPILOT_HEADER
+// Built-in autopilot generated by train --export-header
+#include FLAPPY_AUTOPILOT_HEADER
+#include "simulation.h"
+#endif
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "      --spectate FILE       Watch every agent of a population file (train --population-file)\n";
+    std::cout << "      --birds NUM           Birds to watch, best agents first (default: whole population)\n";
+    std::cout << "      --seed NUM            Course of the first spectator round (default: 1)\n";
+    std::cout << "      --follow NAME         Fly the newest champion of a training run (train --live-feed NAME)\n";
+    std::cout << "      --uncapped            Don't limit the frame rate (to measure spectator fps)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string spectateFile = "";
+    std::string followFeed = "";
+    int spectateBirds = 0;
+    unsigned int spectateSeed = 1;
+    bool uncapped = false;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--spectate") {
+            if (i + 1 < argc) {
+                spectateFile = argv[++i];
+            }
+        } else if (arg == "--birds") {
+            if (i + 1 < argc) {
+                spectateBirds = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                spectateSeed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+        } else if (arg == "--follow") {
+            if (i + 1 < argc) {
+                followFeed = argv[++i];
+            }
+        } else if (arg == "--uncapped") {
+            uncapped = true;
+        }
+    }
+    
+    Spectator spectator;
+    if (!spectateFile.empty() && !spectator.load(spectateFile, spectateBirds)) {
+        std::cerr << "Error: could not load population " << spectateFile << "\n";
+        return 1;
+    }
+    
     // Create SFML window
     sf::RenderWindow window(sf::VideoMode(sf::Vector2u(WINDOW_WIDTH, WINDOW_HEIGHT)), "Flappy Bird");
-    window.setFramerateLimit(60);
+    window.setFramerateLimit(uncapped ? 0 : 60);
     
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -33,12 +91,28 @@ int main() {
     sf::Font font;
     if (!font.openFromFile("/System/Library/Fonts/Helvetica.ttc")) {
         // Fallback or error handling
-        if (!font.openFromFile("/Library/Fonts/Arial.ttf")) {
+        if (!font.openFromFile("/Library/Fonts/Arial.ttf") &&
+            !font.openFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf")) {
             std::cerr << "Error loading font\n";
         }
     }
+    
+    // Spectator mode: the whole population on one course
+    if (!spectateFile.empty()) {
+        spectator.run(window, font, spectateSeed);
+        return 0;
+    }
+    
+    // Follow mode: a live training run's champion and fitness history
+    if (!followFeed.empty()) {
+        spectator.follow(window, font, followFeed, spectateSeed);
+        return 0;
+    }
 
     sf::Clock clock;
+#ifdef FLAPPY_AUTOPILOT_HEADER
+    bool autopilot = false;  // toggled with A
+#endif
     
     while (window.isOpen()) {
         while (auto event = window.pollEvent()) {
@@ -60,10 +134,27 @@ int main() {
                         bird.vy = JUMP_VELOCITY; // Jump/flap
                     }
                 }
+#ifdef FLAPPY_AUTOPILOT_HEADER
+                if (keyPressed->code == sf::Keyboard::Key::A) {
+                    autopilot = !autopilot;
+                    std::cout << "Autopilot " << (autopilot ? "on" : "off") << "\n";
+                }
+#endif
             }
         }
 
         if (gameState == GameState::PLAYING) {
+#ifdef FLAPPY_AUTOPILOT_HEADER
+            // Let the compiled-in network decide, exactly like the headless simulation
+            if (autopilot) {
+                float features[5];
+                extractFeatures(bird, pipes, features);
+                if (autopilot::shouldFlap(features)) {
+                    bird.vy = JUMP_VELOCITY;
+                }
+            }
+#endif
+            
             // Update bird physics
             bird.vy += GRAVITY;
             bird.y += bird.vy;
@@ -0,0 +1,243 @@
+#include "memory_arena.h"
+#include <sys/mman.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// mbind modes and the node mask size we pass (linux/mempolicy.h)
+const int MPOL_PREFERRED_MODE = 1;
+const int MPOL_INTERLEAVE_MODE = 3;
+const int MASK_WORDS = 16;  // up to 1024 nodes
+
+size_t roundToHugePages(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+bool setPolicy(void* address, size_t bytes, int mode, const unsigned long mask[MASK_WORDS]) {
+#if defined(__linux__) && defined(SYS_mbind)
+    return syscall(SYS_mbind, address, bytes, mode, mask, MASK_WORDS * 64, 0) == 0;
+#else
+    (void)address;
+    (void)bytes;
+    (void)mode;
+    (void)mask;
+    return false;
+#endif
+}
+
+// Free lists and bump region of one thread (plain data: no constructor, no
+// destructor, nothing allocated with operator new)
+struct ThreadPool {
+    void* freeLists[ScratchPool::MAX_BLOCK / 64 + 1];
+    char* cursor;
+    char* end;
+    bool started;      // exit hook registered
+    ThreadPool* next;  // in the retired list
+};
+
+thread_local ThreadPool threadPool;
+std::atomic<size_t> slabBytes{0};
+
+// Pools of threads that have exited, waiting for a new thread to take them
+// over. Their slabs can't be unmapped: blocks carved from them may still be
+// alive, or sit in another thread's free lists.
+std::mutex retiredMutex;
+ThreadPool* retiredPools = nullptr;
+
+// Hands the pool of an exiting thread to the retired list; its record lives
+// in a block of the pool itself
+struct PoolRetirer {
+    ~PoolRetirer() {
+        ThreadPool& pool = threadPool;
+        void* record = ScratchPool::allocate(sizeof(ThreadPool));
+        ThreadPool* retired = new (record) ThreadPool(pool);
+        pool = ThreadPool();
+        pool.started = true;  // late frees on this thread are dropped
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired->next = retiredPools;
+        retiredPools = retired;
+    }
+};
+
+thread_local PoolRetirer poolRetirer;
+
+// First use of the pool on this thread: take over a retired pool if there is
+// one, and make sure the pool is retired when the thread exits
+void startThreadPool(ThreadPool& pool) {
+    pool.started = true;
+    (void)&poolRetirer;
+    ThreadPool* retired = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        if (retiredPools) {
+            retired = retiredPools;
+            retiredPools = retired->next;
+        }
+    }
+    if (retired) {
+        for (size_t sizeClass = 0; sizeClass <= ScratchPool::MAX_BLOCK / 64; sizeClass++) {
+            pool.freeLists[sizeClass] = retired->freeLists[sizeClass];
+        }
+        pool.cursor = retired->cursor;
+        pool.end = retired->end;
+        ScratchPool::deallocate(retired, sizeof(ThreadPool));
+    }
+}
+
+} // namespace
+
+// Explicit huge pages first, then a 2 MB aligned mapping the kernel may back
+// with transparent huge pages
+void* mapHugePages(size_t bytes, PageKind& kind) {
+    size_t size = roundToHugePages(bytes);
+#ifdef MAP_HUGETLB
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (address != MAP_FAILED) {
+        kind = PageKind::HUGETLB;
+        return address;
+    }
+#endif
+
+    // Over-allocate by one huge page and trim to an aligned start
+    void* raw = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (aligned > start) {
+        munmap(raw, aligned - start);
+    }
+    size_t tail = start + size + HUGE_PAGE_SIZE - (aligned + size);
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    kind = PageKind::NORMAL;
+#ifdef MADV_HUGEPAGE
+    if (madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE) == 0) {
+        kind = PageKind::TRANSPARENT;
+    }
+#endif
+    return reinterpret_cast<void*>(aligned);
+}
+
+void unmapHugePages(void* address, size_t bytes) {
+    if (address) {
+        munmap(address, roundToHugePages(bytes));
+    }
+}
+
+const char* pageKindName(PageKind kind) {
+    switch (kind) {
+        case PageKind::HUGETLB: return "2 MB huge pages";
+        case PageKind::TRANSPARENT: return "transparent huge pages";
+        default: return "4 KB pages";
+    }
+}
+
+// Nodes listed under /sys/devices/system/node (1 if there is no such list)
+int numaNodeCount() {
+    static const int count = []() {
+        int nodes = 0;
+        if (DIR* dir = opendir("/sys/devices/system/node")) {
+            while (dirent* entry = readdir(dir)) {
+                if (std::strncmp(entry->d_name, "node", 4) == 0 &&
+                    std::isdigit(static_cast<unsigned char>(entry->d_name[4]))) {
+                    nodes++;
+                }
+            }
+            closedir(dir);
+        }
+        return nodes > 0 ? nodes : 1;
+    }();
+    return count;
+}
+
+int currentNumaNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+// Spread pages round-robin over every node
+bool interleaveMemory(void* address, size_t bytes) {
+    int nodes = numaNodeCount();
+    if (nodes < 2) {
+        return false;
+    }
+    unsigned long mask[MASK_WORDS] = {};
+    for (int node = 0; node < nodes && node < MASK_WORDS * 64; node++) {
+        mask[node / 64] |= 1ul << (node % 64);
+    }
+    return setPolicy(address, bytes, MPOL_INTERLEAVE_MODE, mask);
+}
+
+// Prefer one node (falls back to others when it is full)
+bool bindMemory(void* address, size_t bytes, int node) {
+    if (numaNodeCount() < 2 || node < 0 || node >= MASK_WORDS * 64) {
+        return false;
+    }
+    unsigned long mask[MASK_WORDS] = {};
+    mask[node / 64] = 1ul << (node % 64);
+    return setPolicy(address, bytes, MPOL_PREFERRED_MODE, mask);
+}
+
+void* ScratchPool::allocate(size_t bytes) {
+    size_t sizeClass = (bytes + 63) / 64;
+    ThreadPool& pool = threadPool;
+    if (!pool.started) {
+        startThreadPool(pool);
+    }
+    if (void* block = pool.freeLists[sizeClass]) {
+        pool.freeLists[sizeClass] = *static_cast<void**>(block);
+        return block;
+    }
+    size_t blockBytes = sizeClass * 64;
+    if (!pool.cursor || pool.cursor + blockBytes > pool.end) {
+        // New slab on this thread's node (the rest of the old one is dropped)
+        PageKind kind;
+        char* slab = static_cast<char*>(mapHugePages(HUGE_PAGE_SIZE, kind));
+        if (!slab) {
+            throw std::bad_alloc();
+        }
+        bindMemory(slab, HUGE_PAGE_SIZE, currentNumaNode());
+        slabBytes.fetch_add(HUGE_PAGE_SIZE, std::memory_order_relaxed);
+        pool.cursor = slab;
+        pool.end = slab + HUGE_PAGE_SIZE;
+    }
+    void* block = pool.cursor;
+    pool.cursor += blockBytes;
+    return block;
+}
+
+void ScratchPool::deallocate(void* block, size_t bytes) {
+    if (!block) {
+        return;
+    }
+    size_t sizeClass = (bytes + 63) / 64;
+    ThreadPool& pool = threadPool;
+    if (!pool.started) {
+        startThreadPool(pool);
+    }
+    *static_cast<void**>(block) = pool.freeLists[sizeClass];
+    pool.freeLists[sizeClass] = block;
+}
+
+size_t ScratchPool::getSlabBytes() {
+    return slabBytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <cstddef>
+#include <new>
+
+// Huge-page, NUMA-aware memory
+// Large regions (the population) are mapped with explicit 2 MB huge pages
+// when the system has them reserved, otherwise as transparent huge pages,
+// and spread over the NUMA nodes page by page, since any evaluation thread
+// may read any genome. Small per-thread scratch comes from ScratchPool,
+// whose slabs sit on the node of the thread that uses them. Without Linux
+// (or without NUMA) every placement call is a no-op.
+
+enum class PageKind {
+    NORMAL,       // 4 KB pages
+    TRANSPARENT,  // madvise(MADV_HUGEPAGE): huge pages if the kernel can find them
+    HUGETLB       // MAP_HUGETLB: reserved 2 MB pages (vm.nr_hugepages)
+};
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Anonymous zeroed memory, rounded up to whole huge pages (nullptr on failure)
+void* mapHugePages(size_t bytes, PageKind& kind);
+void unmapHugePages(void* address, size_t bytes);
+
+const char* pageKindName(PageKind kind);
+
+// NUMA topology and placement (mbind on Linux)
+int numaNodeCount();
+int currentNumaNode();
+bool interleaveMemory(void* address, size_t bytes);
+bool bindMemory(void* address, size_t bytes, int node);
+
+// Per-thread pool of blocks up to MAX_BLOCK bytes, in 64-byte size classes
+// Each thread carves its blocks from its own huge-page slabs, bound to its
+// node, and reuses the blocks it frees; a block freed by another thread joins
+// that thread's pool. Slabs live as long as the process, so buffers are
+// reused across generations without going back to the system allocator;
+// when a thread exits, the next new thread takes over its pool.
+class ScratchPool {
+public:
+    static const size_t MAX_BLOCK = 8192;
+
+    static void* allocate(size_t bytes);
+    static void deallocate(void* block, size_t bytes);
+
+    // Huge-page slabs mapped so far (all threads)
+    static size_t getSlabBytes();
+};
+
+// Standard allocator over ScratchPool (e.g. for std::allocate_shared)
+template <typename T>
+struct ScratchAllocator {
+    using value_type = T;
+
+    ScratchAllocator() = default;
+    template <typename U>
+    ScratchAllocator(const ScratchAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (bytes > ScratchPool::MAX_BLOCK) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        return static_cast<T*>(ScratchPool::allocate(bytes));
+    }
+
+    void deallocate(T* block, size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (bytes > ScratchPool::MAX_BLOCK) {
+            ::operator delete(block);
+            return;
+        }
+        ScratchPool::deallocate(block, bytes);
+    }
+
+    template <typename U>
+    bool operator==(const ScratchAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const ScratchAllocator<U>&) const { return false; }
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <atomic>
+
+// Throughput counters
+// Every thread gets its own cache-line-sized slot and is the only writer to
+// it, so counting is a plain load/store with no locks or contended atomics.
+// Readers sum all slots with relaxed loads.
+enum class Metric {
+    FRAMES,          // frames simulated
+    FORWARD_PASSES,  // NeuralNetwork::forward calls
+    GAMES,           // games completed
+    ALLOCATIONS,     // operator new calls (counted once a MetricsExporter starts)
+    COUNT
+};
+
+const int METRIC_MAX_THREADS = 256;
+
+struct alignas(64) MetricSlot {
+    std::atomic<unsigned long long> values[static_cast<int>(Metric::COUNT)];
+};
+
+inline MetricSlot metricSlots[METRIC_MAX_THREADS];
+inline std::atomic<int> metricThreads{0};
+
+// Index of this thread's slot; threads past the limit share the last one
+inline int metricSlotIndex() {
+    thread_local int index = std::min(metricThreads.fetch_add(1), METRIC_MAX_THREADS - 1);
+    return index;
+}
+
+// Add to a counter for the calling thread
+inline void countMetric(Metric metric, unsigned long long amount = 1) {
+    int index = metricSlotIndex();
+    auto& value = metricSlots[index].values[static_cast<int>(metric)];
+    if (index < METRIC_MAX_THREADS - 1) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    } else {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+// Sum of a counter over all threads
+inline unsigned long long getMetricTotal(Metric metric) {
+    unsigned long long total = 0;
+    int used = std::min(metricThreads.load(std::memory_order_relaxed), METRIC_MAX_THREADS);
+    for (int i = 0; i < used; i++) {
+        total += metricSlots[i].values[static_cast<int>(metric)].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// Number of threads that have counted anything
+inline int getMetricThreadCount() {
+    return std::min(metricThreads.load(std::memory_order_relaxed), METRIC_MAX_THREADS);
+}
+
+#endif
@@ -0,0 +1,330 @@
+#include "metrics_exporter.h"
+#include "metrics.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+// Count heap allocations while an exporter is running (the allocation
+// profiler build replaces these with its own, which always count). With no
+// exporter started, the only cost over malloc is one relaxed load.
+namespace {
+
+std::atomic<bool> countingAllocations{false};
+
+void* allocate(std::size_t size) {
+    if (countingAllocations.load(std::memory_order_relaxed)) {
+        countMetric(Metric::ALLOCATIONS);
+    }
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+    if (countingAllocations.load(std::memory_order_relaxed)) {
+        countMetric(Metric::ALLOCATIONS);
+    }
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, align, size ? size : 1) == 0) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+#ifndef FLAPPY_ALLOC_PROFILER
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+// Wall-clock seconds since an arbitrary epoch
+static double wallSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// User + system CPU seconds used by the process
+static double cpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Constructor
+MetricsExporter::MetricsExporter(int port, const std::string& filePath, int intervalSeconds)
+    : port(port),
+      filePath(filePath),
+      intervalSeconds(std::max(1, intervalSeconds)),
+      listenSocket(-1),
+      running(false),
+      generation(-1),
+      best(0.0f),
+      average(0.0f),
+      worst(0.0f),
+      framesPerSecond(0.0),
+      cpuUtilization(0.0) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+// Bind the HTTP socket (if any) and start the background thread
+bool MetricsExporter::start() {
+    if (port > 0) {
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenSocket < 0) {
+            return false;
+        }
+        int yes = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // localhost only
+        if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            listen(listenSocket, 8) < 0) {
+            close(listenSocket);
+            listenSocket = -1;
+            return false;
+        }
+    }
+
+    countingAllocations.store(true, std::memory_order_relaxed);
+    running = true;
+    thread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+// Stop the background thread
+void MetricsExporter::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    thread.join();
+    if (listenSocket >= 0) {
+        close(listenSocket);
+        listenSocket = -1;
+    }
+    if (!filePath.empty()) {
+        writeFile();
+    }
+}
+
+// Record generation statistics
+void MetricsExporter::setGeneration(int generation, float best, float average, float worst) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    this->generation = generation;
+    this->best = best;
+    this->average = average;
+    this->worst = worst;
+}
+
+// Background loop: sample rates every second, serve scrapes, write the file
+void MetricsExporter::run() {
+    double lastWall = wallSeconds();
+    double lastCpu = cpuSeconds();
+    unsigned long long lastFrames = getMetricTotal(Metric::FRAMES);
+    double lastWrite = lastWall;
+
+    while (running) {
+        if (listenSocket >= 0) {
+            pollfd fd = {listenSocket, POLLIN, 0};
+            if (poll(&fd, 1, 200) > 0) {
+                int client = accept(listenSocket, nullptr, nullptr);
+                if (client >= 0) {
+                    serveClient(client);
+                }
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+
+        double now = wallSeconds();
+        if (now - lastWall >= 1.0) {
+            sampleRates(lastWall, lastCpu, lastFrames);
+        }
+        if (!filePath.empty() && now - lastWrite >= intervalSeconds) {
+            writeFile();
+            lastWrite = now;
+        }
+    }
+}
+
+// Update frames/sec and core utilization since the last sample
+void MetricsExporter::sampleRates(double& lastWall, double& lastCpu,
+                                  unsigned long long& lastFrames) {
+    double wall = wallSeconds();
+    double cpu = cpuSeconds();
+    unsigned long long frames = getMetricTotal(Metric::FRAMES);
+    double elapsed = wall - lastWall;
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    framesPerSecond = (frames - lastFrames) / elapsed;
+    cpuUtilization = (cpu - lastCpu) / elapsed / cores;
+
+    lastWall = wall;
+    lastCpu = cpu;
+    lastFrames = frames;
+}
+
+// Answer one HTTP request with the current metrics
+void MetricsExporter::serveClient(int client) {
+    // We serve the same page for every path; just drain the request line
+    char request[1024];
+    pollfd fd = {client, POLLIN, 0};
+    if (poll(&fd, 1, 1000) > 0) {
+        recv(client, request, sizeof(request), 0);
+    }
+
+    std::string body = render();
+    std::string response =
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(client, response.data() + sent, response.size() - sent, 0);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    close(client);
+}
+
+// Rewrite the metrics file atomically (write temp, then rename)
+void MetricsExporter::writeFile() {
+    std::string tempPath = filePath + ".tmp";
+    {
+        std::ofstream out(tempPath);
+        if (!out) {
+            return;
+        }
+        out << render();
+    }
+    std::rename(tempPath.c_str(), filePath.c_str());
+}
+
+// Format all metrics in Prometheus text exposition format
+std::string MetricsExporter::render() {
+    int gen;
+    float genBest, genAverage, genWorst;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        gen = generation;
+        genBest = best;
+        genAverage = average;
+        genWorst = worst;
+    }
+
+    std::ostringstream out;
+    auto metric = [&out](const char* name, const char* type, const char* help, double value) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+        out << name << " " << value << "\n";
+    };
+
+    out.precision(12);
+    metric("flappy_frames_total", "counter", "Frames simulated.",
+           getMetricTotal(Metric::FRAMES));
+    metric("flappy_forward_passes_total", "counter", "Neural network forward passes.",
+           getMetricTotal(Metric::FORWARD_PASSES));
+    metric("flappy_games_total", "counter", "Games completed.",
+           getMetricTotal(Metric::GAMES));
+    metric("flappy_allocations_total", "counter", "Heap allocations.",
+           getMetricTotal(Metric::ALLOCATIONS));
+    metric("flappy_process_cpu_seconds_total", "counter", "User and system CPU time.",
+           cpuSeconds());
+    metric("flappy_frames_per_second", "gauge", "Frames simulated per second (last second).",
+           framesPerSecond);
+    metric("flappy_cpu_utilization", "gauge", "Fraction of all cores busy (last second).",
+           cpuUtilization);
+    metric("flappy_threads", "gauge", "Threads that have reported counters.",
+           getMetricThreadCount());
+    metric("flappy_generation", "gauge", "Last completed generation.", gen);
+    metric("flappy_fitness_best", "gauge", "Best fitness of the last generation.", genBest);
+    metric("flappy_fitness_average", "gauge", "Average fitness of the last generation.", genAverage);
+    metric("flappy_fitness_worst", "gauge", "Worst fitness of the last generation.", genWorst);
+    return out.str();
+}
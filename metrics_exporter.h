@@ -0,0 +1,55 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Publishes the counters from metrics.h plus generation statistics in
+// Prometheus text format, over a localhost HTTP endpoint and/or by
+// periodically rewriting a file. All work happens on a background thread.
+class MetricsExporter {
+public:
+    // port <= 0 disables HTTP, empty filePath disables the file
+    MetricsExporter(int port, const std::string& filePath, int intervalSeconds);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Start the background thread; returns false if the port can't be bound
+    bool start();
+
+    // Stop the background thread (writes the file one last time)
+    void stop();
+
+    // Record the statistics of the generation that just finished
+    void setGeneration(int generation, float best, float average, float worst);
+
+private:
+    int port;
+    std::string filePath;
+    int intervalSeconds;
+
+    int listenSocket;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    // Generation statistics (written once per generation)
+    std::mutex statsMutex;
+    int generation;
+    float best, average, worst;
+
+    // Rates over the last sampling interval (exporter thread only)
+    double framesPerSecond;
+    double cpuUtilization;
+
+    void run();
+    void sampleRates(double& lastWall, double& lastCpu, unsigned long long& lastFrames);
+    void serveClient(int client);
+    void writeFile();
+    std::string render();
+};
+
+#endif
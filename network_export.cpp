@@ -0,0 +1,126 @@
+#include "network_export.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+// Print a float so that it parses back to exactly the same value
+static std::string floatLiteral(float value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    std::string literal = buffer;
+    if (literal.find_first_of(".eEn") == std::string::npos) {
+        literal += ".0";
+    }
+    return literal + "f";
+}
+
+// Split flat weights (biases first, then weights) into per-layer arrays
+static void splitLayers(const NeuralNetwork& network,
+                        std::vector<std::vector<float>>& layerWeights,
+                        std::vector<std::vector<float>>& layerBiases) {
+    const auto& topology = network.getTopology();
+    std::vector<float> flat = network.getWeights();
+    size_t index = 0;
+
+    layerBiases.resize(topology.size() - 1);
+    for (size_t layer = 0; layer + 1 < topology.size(); layer++) {
+        layerBiases[layer].assign(flat.begin() + index, flat.begin() + index + topology[layer + 1]);
+        index += topology[layer + 1];
+    }
+
+    layerWeights.resize(topology.size() - 1);
+    for (size_t layer = 0; layer + 1 < topology.size(); layer++) {
+        size_t count = static_cast<size_t>(topology[layer + 1]) * topology[layer];
+        layerWeights[layer].assign(flat.begin() + index, flat.begin() + index + count);
+        index += count;
+    }
+}
+
+// Write the header
+bool exportNetworkHeader(const NeuralNetwork& network, const std::string& filename,
+                         const std::string& nameSpace) {
+    const auto& topology = network.getTopology();
+    std::vector<std::vector<float>> layerWeights, layerBiases;
+    splitLayers(network, layerWeights, layerBiases);
+
+    std::ostringstream out;
+    std::string guard = "FLAPPY_" + nameSpace + "_H";
+    std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+
+    out << "// Generated by train --export-header. Do not edit.\n";
+    out << "// Network topology:";
+    for (int size : topology) {
+        out << " " << size;
+    }
+    out << " (ReLU hidden layers, sigmoid output, flap if output > 0.5)\n";
+    out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+    out << "#include <algorithm>\n#include <cmath>\n\n";
+    out << "namespace " << nameSpace << " {\n\n";
+
+    // Weights as constexpr arrays, W then B for each layer
+    for (size_t layer = 0; layer < layerWeights.size(); layer++) {
+        int numNeurons = topology[layer + 1];
+        int numInputs = topology[layer];
+        out << "constexpr float W" << layer << "[" << numNeurons << "][" << numInputs << "] = {\n";
+        for (int n = 0; n < numNeurons; n++) {
+            out << "    {";
+            for (int i = 0; i < numInputs; i++) {
+                out << floatLiteral(layerWeights[layer][n * numInputs + i])
+                    << (i + 1 < numInputs ? ", " : "");
+            }
+            out << "}" << (n + 1 < numNeurons ? "," : "") << "\n";
+        }
+        out << "};\n";
+        out << "constexpr float B" << layer << "[" << numNeurons << "] = {";
+        for (int n = 0; n < numNeurons; n++) {
+            out << floatLiteral(layerBiases[layer][n]) << (n + 1 < numNeurons ? ", " : "");
+        }
+        out << "};\n\n";
+    }
+
+    // Fully unrolled forward pass, same operation order as NeuralNetwork::forward
+    out << "inline bool shouldFlap(const float features[" << topology[0] << "]) {\n";
+    std::string input = "features[";
+    for (size_t layer = 0; layer < layerWeights.size(); layer++) {
+        bool lastLayer = layer + 1 == layerWeights.size();
+        int numNeurons = topology[layer + 1];
+        int numInputs = topology[layer];
+        out << "    // Layer " << layer << ": " << numInputs << " -> " << numNeurons
+            << (lastLayer ? " (sigmoid)\n" : " (ReLU)\n");
+
+        for (int n = 0; n < numNeurons; n++) {
+            std::string name = "h" + std::to_string(layer) + "_" + std::to_string(n);
+            out << "    float " << name << " = B" << layer << "[" << n << "];\n";
+            for (int i = 0; i < numInputs; i++) {
+                out << "    " << name << " += W" << layer << "[" << n << "][" << i << "] * "
+                    << input << i << "];\n";
+            }
+            if (!lastLayer) {
+                out << "    " << name << " = std::max(0.0f, " << name << ");\n";
+            }
+        }
+        if (!lastLayer) {
+            // Gather this layer's outputs so the next layer indexes them like features
+            std::string array = "a" + std::to_string(layer);
+            out << "    const float " << array << "[" << numNeurons << "] = {";
+            for (int n = 0; n < numNeurons; n++) {
+                out << "h" << layer << "_" << n << (n + 1 < numNeurons ? ", " : "");
+            }
+            out << "};\n";
+            input = array + "[";
+        }
+    }
+    std::string output = "h" + std::to_string(layerWeights.size() - 1) + "_0";
+    out << "    return 1.0f / (1.0f + std::exp(-" << output << ")) > 0.5f;\n";
+    out << "}\n\n";
+    out << "} // namespace " << nameSpace << "\n\n#endif\n";
+
+    std::ofstream file(filename);
+    if (!file) {
+        return false;
+    }
+    file << out.str();
+    return static_cast<bool>(file);
+}
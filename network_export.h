@@ -0,0 +1,13 @@
+#ifndef NETWORK_EXPORT_H
+#define NETWORK_EXPORT_H
+
+#include "neural_network.h"
+#include <string>
+
+// Ahead-of-time export of a trained network to a self-contained C++ header
+// The header holds the weights as constexpr arrays and a fully unrolled
+// bool shouldFlap(const float features[5]) in namespace nameSpace.
+bool exportNetworkHeader(const NeuralNetwork& network, const std::string& filename,
+                         const std::string& nameSpace = "autopilot");
+
+#endif
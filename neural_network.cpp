@@ -1,8 +1,15 @@
 #include "neural_network.h"
+#include "metrics.h"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <fstream>
 #include <numeric>
 
+// Saved network file headers: fp32 weights, and weights of a stated precision
+static const char NETWORK_MAGIC[4] = {'F', 'N', 'N', '1'};
+static const char NETWORK_MAGIC_PRECISION[4] = {'F', 'N', 'N', '2'};
+
 // ReLU activation function
 float NeuralNetwork::relu(float x) {
     return std::max(0.0f, x);
@@ -42,9 +49,113 @@ NeuralNetwork::NeuralNetwork(const std::vector<int>& topology, std::mt19937& gen
     }
 }
 
+// Constructor: topology plus flat weights
+NeuralNetwork::NeuralNetwork(const std::vector<int>& topology, const std::vector<float>& flatWeights)
+    : topology(topology) {
+    weights.resize(topology.size() - 1);
+    biases.resize(topology.size() - 1);
+    
+    for (size_t layer = 0; layer < topology.size() - 1; layer++) {
+        weights[layer].assign(topology[layer + 1], std::vector<float>(topology[layer], 0.0f));
+        biases[layer].assign(topology[layer + 1], 0.0f);
+    }
+    
+    setWeights(flatWeights);
+}
+
 // Copy constructor
 NeuralNetwork::NeuralNetwork(const NeuralNetwork& other)
-    : topology(other.topology), weights(other.weights), biases(other.biases) {
+    : topology(other.topology), weights(other.weights), biases(other.biases),
+      mask(other.mask), sparseWeights(other.sparseWeights) {
+}
+
+// Build the sparse row structure of a pruning mask
+PruneMask::PruneMask(const std::vector<int>& topology, const std::vector<uint8_t>& pruned)
+    : numConnections(0), numPruned(0) {
+    size_t gene = 0;
+    for (size_t layer = 1; layer < topology.size(); layer++) {
+        gene += topology[layer];  // biases come first in the flat layout
+    }
+    this->pruned.assign(gene, 0);
+    
+    rowStart.resize(topology.size() - 1);
+    for (size_t layer = 0; layer + 1 < topology.size(); layer++) {
+        rowStart[layer].push_back(static_cast<int>(columns.size()));
+        for (int neuron = 0; neuron < topology[layer + 1]; neuron++) {
+            for (int input = 0; input < topology[layer]; input++, gene++) {
+                bool cut = gene < pruned.size() && pruned[gene];
+                this->pruned.push_back(cut);
+                numConnections++;
+                if (cut) {
+                    numPruned++;
+                } else {
+                    columns.push_back(input);
+                }
+            }
+            rowStart[layer].push_back(static_cast<int>(columns.size()));
+        }
+    }
+}
+
+// Switch to (or off) a pruned, sparse network
+void NeuralNetwork::setPruneMask(std::shared_ptr<const PruneMask> mask) {
+    this->mask = std::move(mask);
+    if (!this->mask) {
+        sparseWeights.clear();
+        return;
+    }
+    size_t gene = getNumWeights() - this->mask->numConnections;
+    for (auto& layer : weights) {
+        for (auto& neuron : layer) {
+            for (auto& weight : neuron) {
+                if (this->mask->pruned[gene++]) {
+                    weight = 0.0f;
+                }
+            }
+        }
+    }
+    gatherSparseWeights();
+}
+
+// Copy the kept weights into row order; called whenever weights change, so
+// forward() never writes to the network (games of one agent share it)
+void NeuralNetwork::gatherSparseWeights() {
+    if (!mask) {
+        return;
+    }
+    sparseWeights.resize(mask->columns.size());
+    size_t kept = 0;
+    for (size_t layer = 0; layer < weights.size(); layer++) {
+        for (size_t neuron = 0; neuron < weights[layer].size(); neuron++) {
+            for (int k = mask->rowStart[layer][neuron]; k < mask->rowStart[layer][neuron + 1]; k++) {
+                sparseWeights[kept++] = weights[layer][neuron][mask->columns[k]];
+            }
+        }
+    }
+}
+
+// Sparse forward pass: only the kept weights, in the same order as the
+// dense loop (a pruned weight only ever adds 0), into per-thread scratch
+float NeuralNetwork::forwardSparse(const std::vector<float>& inputs) {
+    thread_local std::vector<float> current;
+    thread_local std::vector<float> next;
+    current.assign(inputs.begin(), inputs.end());
+    
+    for (size_t layer = 0; layer < weights.size(); layer++) {
+        const std::vector<int>& rows = mask->rowStart[layer];
+        size_t numNeurons = biases[layer].size();
+        bool lastLayer = layer == weights.size() - 1;
+        next.resize(numNeurons);
+        for (size_t neuron = 0; neuron < numNeurons; neuron++) {
+            float sum = biases[layer][neuron];
+            for (int k = rows[neuron]; k < rows[neuron + 1]; k++) {
+                sum += sparseWeights[k] * current[mask->columns[k]];
+            }
+            next[neuron] = lastLayer ? sigmoid(sum) : relu(sum);
+        }
+        current.swap(next);
+    }
+    return current[0];
 }
 
 // Forward propagation
@@ -53,11 +164,19 @@ float NeuralNetwork::forward(const std::vector<float>& inputs) {
         return 0.0f; // Error: wrong input size
     }
     
-    std::vector<float> current = inputs;
+    countMetric(Metric::FORWARD_PASSES);
+    if (mask) {
+        return forwardSparse(inputs);
+    }
+    
+    // Per-thread activations, reused by every pass (no allocation per frame)
+    thread_local std::vector<float> current;
+    thread_local std::vector<float> next;
+    current.assign(inputs.begin(), inputs.end());
     
     // Propagate through each layer
     for (size_t layer = 0; layer < weights.size(); layer++) {
-        std::vector<float> next(weights[layer].size());
+        next.resize(weights[layer].size());
         
         for (size_t neuron = 0; neuron < weights[layer].size(); neuron++) {
             // Calculate weighted sum
@@ -76,16 +195,133 @@ float NeuralNetwork::forward(const std::vector<float>& inputs) {
             }
         }
         
-        current = next;
+        current.swap(next);
     }
     
     // Return output (single value for our network)
     return current[0];
 }
 
+// Batched forward propagation
+// Activations are kept feature-major ([neuron][sample]) so the inner loop
+// runs over the batch with one weight broadcast, which vectorizes.
+void NeuralNetwork::forwardBatch(const float* inputs, int batchSize, float* outputs) const {
+    countMetric(Metric::FORWARD_PASSES, batchSize);
+    
+    int numInputs = topology[0];
+    std::vector<float> current(static_cast<size_t>(numInputs) * batchSize);
+    for (int b = 0; b < batchSize; b++) {
+        for (int i = 0; i < numInputs; i++) {
+            current[static_cast<size_t>(i) * batchSize + b] = inputs[static_cast<size_t>(b) * numInputs + i];
+        }
+    }
+    
+    std::vector<float> next;
+    for (size_t layer = 0; layer < weights.size(); layer++) {
+        bool lastLayer = layer == weights.size() - 1;
+        next.assign(weights[layer].size() * batchSize, 0.0f);
+        
+        for (size_t neuron = 0; neuron < weights[layer].size(); neuron++) {
+            float* out = next.data() + neuron * batchSize;
+            std::fill(out, out + batchSize, biases[layer][neuron]);
+            
+            for (size_t input = 0; input < weights[layer][neuron].size(); input++) {
+                float w = weights[layer][neuron][input];
+                const float* in = current.data() + input * batchSize;
+                for (int b = 0; b < batchSize; b++) {
+                    out[b] += w * in[b];
+                }
+            }
+            
+            for (int b = 0; b < batchSize; b++) {
+                out[b] = lastLayer ? sigmoid(out[b]) : relu(out[b]);
+            }
+        }
+        
+        current.swap(next);
+    }
+    
+    std::copy(current.begin(), current.begin() + batchSize, outputs);
+}
+
+// Save network: magic, layer count, topology, [precision,] flat weights
+bool NeuralNetwork::save(const std::string& filename, GenomePrecision precision) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    
+    std::vector<float> flat = getWeights();
+    uint32_t numLayers = static_cast<uint32_t>(topology.size());
+    bool fp32 = precision == GenomePrecision::FP32;
+    out.write(fp32 ? NETWORK_MAGIC : NETWORK_MAGIC_PRECISION, sizeof(NETWORK_MAGIC));
+    out.write(reinterpret_cast<const char*>(&numLayers), sizeof(numLayers));
+    for (int size : topology) {
+        int32_t value = size;
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    if (!fp32) {
+        uint32_t value = static_cast<uint32_t>(precision);
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    
+    std::vector<char> packed(flat.size() * genomeBytesPerWeight(precision));
+    encodeGenome(flat.data(), flat.size(), precision, packed.data());
+    out.write(packed.data(), packed.size());
+    
+    return static_cast<bool>(out);
+}
+
+// Load network saved with save(); returns nullptr on error
+std::unique_ptr<NeuralNetwork> NeuralNetwork::load(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[4];
+    uint32_t numLayers = 0;
+    if (!in.read(magic, sizeof(magic)) ||
+        (!std::equal(magic, magic + 4, NETWORK_MAGIC) &&
+         !std::equal(magic, magic + 4, NETWORK_MAGIC_PRECISION)) ||
+        !in.read(reinterpret_cast<char*>(&numLayers), sizeof(numLayers)) ||
+        numLayers < 2 || numLayers > 64) {
+        return nullptr;
+    }
+    
+    std::vector<int> topology(numLayers);
+    size_t numWeights = 0;
+    for (uint32_t i = 0; i < numLayers; i++) {
+        int32_t value = 0;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)) || value <= 0) {
+            return nullptr;
+        }
+        topology[i] = value;
+        if (i > 0) {
+            numWeights += static_cast<size_t>(topology[i]) * (topology[i - 1] + 1);
+        }
+    }
+    
+    GenomePrecision precision = GenomePrecision::FP32;
+    if (std::equal(magic, magic + 4, NETWORK_MAGIC_PRECISION)) {
+        uint32_t value = 0;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)) ||
+            value > static_cast<uint32_t>(GenomePrecision::BF16)) {
+            return nullptr;
+        }
+        precision = static_cast<GenomePrecision>(value);
+    }
+    
+    std::vector<char> packed(numWeights * genomeBytesPerWeight(precision));
+    if (!in.read(packed.data(), packed.size())) {
+        return nullptr;
+    }
+    std::vector<float> flat(numWeights);
+    decodeGenome(packed.data(), numWeights, precision, flat.data());
+    
+    return std::make_unique<NeuralNetwork>(topology, flat);
+}
+
 // Get all weights as flat vector
 std::vector<float> NeuralNetwork::getWeights() const {
     std::vector<float> flat;
+    flat.reserve(getNumWeights());
     
     // Add biases first, then weights
     for (size_t layer = 0; layer < biases.size(); layer++) {
@@ -128,6 +364,7 @@ void NeuralNetwork::setWeights(const std::vector<float>& flat) {
             }
         }
     }
+    gatherSparseWeights();
 }
 
 // Get total number of weights (including biases)
@@ -150,16 +387,46 @@ int NeuralNetwork::getNumWeights() const {
 }
 
 // Mutate: add Gaussian noise to random weights
-void NeuralNetwork::mutate(float mutationRate, float mutationStrength, std::mt19937& gen) {
-    std::uniform_real_distribution<float> probDist(0.0f, 1.0f);
-    std::normal_distribution<float> noiseDist(0.0f, mutationStrength);
+// Draws are batched: one uniform per weight, then one normal per mutated weight
+void NeuralNetwork::mutate(float mutationRate, float mutationStrength, Rng& rng,
+                           std::vector<WeightDelta>* deltas) {
+    thread_local std::vector<float> draws;
+    thread_local std::vector<float> noise;
+    
+    draws.resize(getNumWeights());
+    rng.fillUniform(draws.data(), draws.size());
+    size_t mutated = 0;
+    for (float draw : draws) {
+        mutated += draw < mutationRate;
+    }
+    noise.resize(mutated);
+    rng.fillNormal(noise.data(), mutated, 0.0f, mutationStrength);
+    
+    if (deltas) {
+        deltas->clear();
+    }
+    
+    // Pruned genes draw their noise like any other but keep their zero
+    const uint8_t* pruned = mask ? mask->pruned.data() : nullptr;
+    size_t index = 0;
+    size_t nextNoise = 0;
+    auto mutateValue = [&](float& value) {
+        if (draws[index++] < mutationRate) {
+            if (pruned && pruned[index - 1]) {
+                nextNoise++;
+                return;
+            }
+            if (deltas) {
+                deltas->push_back({static_cast<uint32_t>(index - 1), noise[nextNoise]});
+            }
+            value += noise[nextNoise++];
+        }
+    };
     
     // Mutate biases
     for (auto& layer : biases) {
         for (auto& bias : layer) {
-            if (probDist(gen) < mutationRate) {
-                bias += noiseDist(gen);
-            }
+            mutateValue(bias);
         }
     }
     
@@ -167,32 +434,54 @@ void NeuralNetwork::mutate(float mutationRate, float mutationStrength, std::mt19
     for (auto& layer : weights) {
         for (auto& neuron : layer) {
             for (auto& weight : neuron) {
-                if (probDist(gen) < mutationRate) {
-                    weight += noiseDist(gen);
-                }
+                mutateValue(weight);
             }
         }
     }
+    gatherSparseWeights();
 }
 
 // Crossover: uniform crossover (randomly pick from each parent)
+// One random bit per gene; genes start as parent1's and take parent2's on a set bit.
+// The child is pruned like parent1; pruned genes are zero in both parents.
 NeuralNetwork NeuralNetwork::crossover(const NeuralNetwork& parent1, 
                                         const NeuralNetwork& parent2, 
-                                        std::mt19937& gen) {
+                                        Rng& rng,
+                                        std::vector<uint64_t>* mask) {
     // Both parents must have same topology
     if (parent1.topology != parent2.topology) {
         return parent1; // Return first parent if mismatch
     }
     
-    NeuralNetwork child(parent1.topology, gen);
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    NeuralNetwork child(parent1);
+    if (mask) {
+        mask->clear();
+    }
+    uint64_t bits = 0;
+    int available = 0;
+    int remaining = mask ? child.getNumWeights() : 0;
+    auto fromParent2 = [&]() {
+        if (available == 0) {
+            bits = rng();
+            available = 64;
+            if (mask) {
+                // Unused high bits of the last word are cleared
+                mask->push_back(remaining < 64 ? bits & ((uint64_t(1) << remaining) - 1) : bits);
+            }
+            remaining -= 64;
+        }
+        bool pick = bits & 1;
+        bits >>= 1;
+        available--;
+        return pick;
+    };
     
     // Crossover biases
     for (size_t layer = 0; layer < child.biases.size(); layer++) {
         for (size_t neuron = 0; neuron < child.biases[layer].size(); neuron++) {
-            child.biases[layer][neuron] = (dist(gen) < 0.5f) 
-                ? parent1.biases[layer][neuron] 
-                : parent2.biases[layer][neuron];
+            if (fromParent2()) {
+                child.biases[layer][neuron] = parent2.biases[layer][neuron];
+            }
         }
     }
     
@@ -200,12 +489,13 @@ NeuralNetwork NeuralNetwork::crossover(const NeuralNetwork& parent1,
     for (size_t layer = 0; layer < child.weights.size(); layer++) {
         for (size_t neuron = 0; neuron < child.weights[layer].size(); neuron++) {
             for (size_t weight = 0; weight < child.weights[layer][neuron].size(); weight++) {
-                child.weights[layer][neuron][weight] = (dist(gen) < 0.5f)
-                    ? parent1.weights[layer][neuron][weight]
-                    : parent2.weights[layer][neuron][weight];
+                if (fromParent2()) {
+                    child.weights[layer][neuron][weight] = parent2.weights[layer][neuron][weight];
+                }
             }
         }
     }
+    child.gatherSparseWeights();
     
     return child;
 }
@@ -1,8 +1,33 @@
 #ifndef NEURAL_NETWORK_H
 #define NEURAL_NETWORK_H
 
+#include "genome_codec.h"
+#include "rng.h"
+#include <cstdint>
 #include <vector>
 #include <random>
+#include <memory>
+#include <string>
+
+// One mutated gene: index into the flat layout of getWeights and the noise added
+struct WeightDelta {
+    uint32_t index;
+    float delta;
+};
+
+// Pruned connections of a topology, shared by every network pruned alike
+// The surviving connection weights of each neuron are listed in compressed
+// sparse row form: kept weights rowStart[layer][neuron] up to
+// rowStart[layer][neuron + 1] read inputs columns[...]. Biases are never pruned.
+struct PruneMask {
+    std::vector<uint8_t> pruned;            // per gene of the flat layout, 1 = pruned
+    std::vector<std::vector<int>> rowStart; // [layer][neuron], numNeurons + 1 per layer
+    std::vector<int> columns;               // input index of every kept weight
+    int numConnections;                     // connection weights (genes minus biases)
+    int numPruned;
+    
+    PruneMask(const std::vector<int>& topology, const std::vector<uint8_t>& pruned);
+};
 
 class NeuralNetwork {
 private:
@@ -10,6 +35,12 @@ private:
     std::vector<std::vector<std::vector<float>>> weights;  // [layer][neuron][weight]
     std::vector<std::vector<float>> biases;  // [layer][neuron]
     
+    // Pruning (nullptr = dense): the kept weights in the order of mask->columns
+    std::shared_ptr<const PruneMask> mask;
+    std::vector<float> sparseWeights;
+    void gatherSparseWeights();
+    float forwardSparse(const std::vector<float>& inputs);
+    
     // Activation functions
     static float relu(float x);
     static float sigmoid(float x);
@@ -21,12 +52,30 @@ public:
     // Constructor: takes topology (e.g., {5, 8, 4, 1})
     NeuralNetwork(const std::vector<int>& topology, std::mt19937& gen);
     
+    // Constructor: takes topology and flat weights (as returned by getWeights)
+    NeuralNetwork(const std::vector<int>& topology, const std::vector<float>& flatWeights);
+    
     // Copy constructor
     NeuralNetwork(const NeuralNetwork& other);
     
+    // Assignment and moves (memberwise, like the copy constructor)
+    NeuralNetwork& operator=(const NeuralNetwork& other) = default;
+    NeuralNetwork(NeuralNetwork&& other) noexcept = default;
+    NeuralNetwork& operator=(NeuralNetwork&& other) noexcept = default;
+    
     // Forward propagation: returns output (0-1 range)
     float forward(const std::vector<float>& inputs);
     
+    // Batched forward propagation
+    // inputs: batchSize rows of topology[0] features, outputs: batchSize values
+    void forwardBatch(const float* inputs, int batchSize, float* outputs) const;
+    
+    // Save to / load from a binary file (topology + flat weights)
+    // Weights are written in the given precision; load() accepts any.
+    bool save(const std::string& filename,
+              GenomePrecision precision = GenomePrecision::FP32) const;
+    static std::unique_ptr<NeuralNetwork> load(const std::string& filename);
+    
     // Get all weights as flat vector (for mutation/crossover)
     std::vector<float> getWeights() const;
     
@@ -37,12 +86,22 @@ public:
     int getNumWeights() const;
     
     // Mutate: add Gaussian noise to weights
-    void mutate(float mutationRate, float mutationStrength, std::mt19937& gen);
+    // deltas (optional) receives every mutated gene, in index order
+    void mutate(float mutationRate, float mutationStrength, Rng& rng,
+                std::vector<WeightDelta>* deltas = nullptr);
     
     // Crossover: create child from two parents (uniform crossover)
+    // mask (optional) receives one bit per gene of the flat layout, set
+    // where the child took parent2's gene (bit i of word i / 64)
     static NeuralNetwork crossover(const NeuralNetwork& parent1, 
                                    const NeuralNetwork& parent2, 
-                                   std::mt19937& gen);
+                                   Rng& rng,
+                                   std::vector<uint64_t>* mask = nullptr);
+    
+    // Prune the connections set in mask (nullptr = back to dense): they are
+    // zeroed, left at zero by mutate() and crossover(), and skipped by forward()
+    void setPruneMask(std::shared_ptr<const PruneMask> mask);
+    const std::shared_ptr<const PruneMask>& getPruneMask() const { return mask; }
     
     // Get topology
     const std::vector<int>& getTopology() const { return topology; }
@@ -0,0 +1,194 @@
+#include "policy_table.h"
+#include "neural_network.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <unordered_map>
+
+// Saved table file header
+static const char TABLE_MAGIC[4] = {'F', 'L', 'U', 'T'};
+
+// Interior bin edges for one feature: quantiles of the visited values,
+// de-duplicated, then topped up by splitting the widest gaps
+static std::vector<float> quantileEdges(std::vector<float> values, int bins) {
+    std::sort(values.begin(), values.end());
+    std::vector<float> edges;
+    for (int k = 1; k < bins; k++) {
+        edges.push_back(values[values.size() * k / bins]);
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    float low = values.front();
+    float high = values.back();
+    while (static_cast<int>(edges.size()) < bins - 1) {
+        // Widest interval between low, the edges and high
+        float previous = low;
+        float bestWidth = -1.0f;
+        float bestMiddle = 0.0f;
+        for (size_t i = 0; i <= edges.size(); i++) {
+            float next = i < edges.size() ? edges[i] : high;
+            if (next - previous > bestWidth) {
+                bestWidth = next - previous;
+                bestMiddle = previous + (next - previous) / 2.0f;
+            }
+            previous = next;
+        }
+        if (bestWidth <= 0.0f) {
+            bestMiddle = high + 1.0f + static_cast<float>(edges.size());  // degenerate feature
+        }
+        edges.insert(std::upper_bound(edges.begin(), edges.end(), bestMiddle), bestMiddle);
+    }
+    return edges;
+}
+
+// Build a table from a network and visited states
+PolicyTable PolicyTable::distill(NeuralNetwork& network, const std::vector<Features>& visited,
+                                 int bins, float boundaryFraction) {
+    PolicyTable table;
+    table.bins = std::min(MAX_BINS, std::max(MIN_BINS, bins));
+    table.numCells = 1;
+    for (int f = 0; f < NUM_FEATURES; f++) {
+        table.numCells *= table.bins;
+    }
+    table.bits.assign((table.numCells + 63) / 64, 0);
+
+    // Network output on every visited state
+    std::vector<float> outputs(visited.size());
+    if (!visited.empty()) {
+        network.forwardBatch(visited[0].data(), static_cast<int>(visited.size()), outputs.data());
+    }
+
+    // Edges go at quantiles of the least confident states, where the
+    // decision flips; elsewhere a coarse cell is right anyway
+    std::vector<size_t> order(visited.size());
+    std::iota(order.begin(), order.end(), 0);
+    size_t boundarySize = std::min(visited.size(), std::max<size_t>(
+        2, static_cast<size_t>(visited.size() * boundaryFraction)));
+    std::partial_sort(order.begin(), order.begin() + boundarySize, order.end(),
+                      [&outputs](size_t a, size_t b) {
+                          return std::abs(outputs[a] - 0.5f) < std::abs(outputs[b] - 0.5f);
+                      });
+
+    // Per-feature edges and overall range (for centres of the outer bins)
+    std::vector<float> low(NUM_FEATURES, 0.0f), high(NUM_FEATURES, 1.0f);
+    for (int f = 0; f < NUM_FEATURES; f++) {
+        std::vector<float> values;
+        values.reserve(boundarySize);
+        for (size_t k = 0; k < boundarySize; k++) {
+            values.push_back(visited[order[k]][f]);
+        }
+        if (values.empty()) {
+            values = {0.0f, 1.0f};
+        }
+        std::vector<float> featureEdges = quantileEdges(values, table.bins);
+        table.edges.insert(table.edges.end(), featureEdges.begin(), featureEdges.end());
+        if (!visited.empty()) {
+            low[f] = high[f] = visited[0][f];
+        }
+        for (const auto& state : visited) {
+            low[f] = std::min(low[f], state[f]);
+            high[f] = std::max(high[f], state[f]);
+        }
+    }
+
+    // Every cell: network decision at its centre, evaluated in batches
+    const int BATCH = 4096;
+    std::vector<float> inputs(BATCH * NUM_FEATURES);
+    std::vector<float> cellOutputs(BATCH);
+    for (size_t first = 0; first < table.numCells; first += BATCH) {
+        int count = static_cast<int>(std::min<size_t>(BATCH, table.numCells - first));
+        for (int c = 0; c < count; c++) {
+            size_t cell = first + c;
+            for (int f = NUM_FEATURES - 1; f >= 0; f--) {
+                int bin = static_cast<int>(cell % table.bins);
+                cell /= table.bins;
+                const float* featureEdges = table.edges.data() + f * (table.bins - 1);
+                float lo = bin == 0 ? low[f] : featureEdges[bin - 1];
+                float hi = bin == table.bins - 1 ? high[f] : featureEdges[bin];
+                inputs[c * NUM_FEATURES + f] = lo + (hi - lo) / 2.0f;
+            }
+        }
+        network.forwardBatch(inputs.data(), count, cellOutputs.data());
+        for (int c = 0; c < count; c++) {
+            if (cellOutputs[c] > 0.5f) {
+                table.bits[(first + c) / 64] |= uint64_t(1) << ((first + c) % 64);
+            }
+        }
+    }
+
+    // Visited cells: majority of the network's decisions on real states
+    std::unordered_map<size_t, int> votes;  // flaps minus non-flaps
+    for (size_t i = 0; i < visited.size(); i++) {
+        votes[table.cellOf(visited[i].data())] += outputs[i] > 0.5f ? 1 : -1;
+    }
+    for (const auto& vote : votes) {
+        uint64_t mask = uint64_t(1) << (vote.first % 64);
+        if (vote.second > 0) {
+            table.bits[vote.first / 64] |= mask;
+        } else if (vote.second < 0) {
+            table.bits[vote.first / 64] &= ~mask;
+        }
+    }
+
+    return table;
+}
+
+// Bin of one feature value
+int PolicyTable::binOf(int feature, float value) const {
+    const float* begin = edges.data() + feature * (bins - 1);
+    return static_cast<int>(std::upper_bound(begin, begin + bins - 1, value) - begin);
+}
+
+// Cell index of a feature vector
+size_t PolicyTable::cellOf(const float features[NUM_FEATURES]) const {
+    size_t cell = 0;
+    for (int f = 0; f < NUM_FEATURES; f++) {
+        cell = cell * bins + binOf(f, features[f]);
+    }
+    return cell;
+}
+
+// Table lookup
+bool PolicyTable::shouldFlap(const float features[NUM_FEATURES]) const {
+    size_t cell = cellOf(features);
+    return (bits[cell / 64] >> (cell % 64)) & 1;
+}
+
+// Save table: magic, bins, edges, bits
+bool PolicyTable::save(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    int32_t numBins = bins;
+    out.write(TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&numBins), sizeof(numBins));
+    out.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(float));
+    out.write(reinterpret_cast<const char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    return static_cast<bool>(out);
+}
+
+// Load table saved with save()
+bool PolicyTable::load(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[4];
+    int32_t numBins = 0;
+    if (!in.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + 4, TABLE_MAGIC) ||
+        !in.read(reinterpret_cast<char*>(&numBins), sizeof(numBins)) ||
+        numBins < MIN_BINS || numBins > MAX_BINS) {
+        return false;
+    }
+
+    bins = numBins;
+    numCells = 1;
+    for (int f = 0; f < NUM_FEATURES; f++) {
+        numCells *= bins;
+    }
+    edges.resize(NUM_FEATURES * (bins - 1));
+    bits.resize((numCells + 63) / 64);
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char*>(edges.data()), edges.size() * sizeof(float)) &&
+        in.read(reinterpret_cast<char*>(bits.data()), bits.size() * sizeof(uint64_t)));
+}
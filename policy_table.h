@@ -0,0 +1,51 @@
+#ifndef POLICY_TABLE_H
+#define POLICY_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class NeuralNetwork;
+
+// Lookup-table policy distilled from a NeuralNetwork
+// Each of the 5 features is quantized into `bins` intervals whose edges are
+// quantiles of the states visited in real games where the network is least
+// sure, so resolution goes to the decision boundary the agent actually
+// plays near. The flap decision of every cell is one bit.
+class PolicyTable {
+public:
+    static const int NUM_FEATURES = 5;
+    static const int MIN_BINS = 2;
+    static const int MAX_BINS = 64;  // 64^5 cells = 128 MB of bits
+    using Features = std::array<float, NUM_FEATURES>;
+
+    // Build a table: each cell takes the network's majority decision over the
+    // visited states that fall into it, or its decision at the cell centre.
+    // bins is clamped to [MIN_BINS, MAX_BINS]
+    // boundaryFraction: share of visited states (least confident first) used to place edges
+    static PolicyTable distill(NeuralNetwork& network, const std::vector<Features>& visited,
+                               int bins, float boundaryFraction = 0.05f);
+
+    // O(1) decision: a few comparisons per feature plus one bit test
+    bool shouldFlap(const float features[NUM_FEATURES]) const;
+
+    // Save to / load from a binary file; load returns false on error
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+
+    int getBins() const { return bins; }
+    size_t getNumCells() const { return numCells; }
+    size_t getSizeBytes() const { return bits.size() * sizeof(uint64_t); }
+
+private:
+    int bins = 0;
+    size_t numCells = 0;
+    std::vector<float> edges;   // [feature][bins - 1] interior edges, ascending
+    std::vector<uint64_t> bits; // one bit per cell
+
+    int binOf(int feature, float value) const;
+    size_t cellOf(const float features[NUM_FEATURES]) const;
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include "population_store.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const char STORE_MAGIC[4] = {'F', 'P', 'O', 'P'};
+const uint32_t STORE_VERSION = 1;
+const int MAX_LAYERS = 16;
+const size_t DATA_OFFSET = 4096;  // records start on a page boundary
+const size_t RECORD_ALIGN = 16;   // aligned headers; tighter packing than cache lines
+
+// First page of the file
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numRecords;
+    uint32_t numWeights;
+    uint32_t recordStride;
+    uint32_t currentBuffer;
+    uint32_t numLayers;
+    int32_t topology[MAX_LAYERS];
+    uint32_t precision;  // GenomePrecision
+};
+
+// Weights and biases of a dense network of this topology (0 if a layer is empty)
+size_t topologyWeights(const int32_t* topology, uint32_t numLayers) {
+    size_t total = 0;
+    for (uint32_t layer = 0; layer + 1 < numLayers; layer++) {
+        if (topology[layer] <= 0 || topology[layer + 1] <= 0) {
+            return 0;
+        }
+        total += (static_cast<size_t>(topology[layer]) + 1) * static_cast<size_t>(topology[layer + 1]);
+    }
+    return total;
+}
+
+} // namespace
+
+PopulationStore::PopulationStore()
+    : fd(-1), base(nullptr), mappedSize(0), recordStride(0), dataOffset(DATA_OFFSET),
+      numRecords(0), numWeights(0), precision(GenomePrecision::FP32), hugePages(false),
+      pageKind(PageKind::NORMAL) {
+}
+
+PopulationStore::~PopulationStore() {
+    close();
+}
+
+// Map the whole file (or anonymous memory of that size)
+bool PopulationStore::map(size_t size, bool writable, bool anonymous) {
+    if (anonymous && hugePages) {
+        base = static_cast<unsigned char*>(mapHugePages(size, pageKind));
+        if (!base) {
+            return false;
+        }
+        mappedSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        interleaveMemory(base, mappedSize);
+        return true;
+    }
+    pageKind = PageKind::NORMAL;
+    int protection = PROT_READ | (writable ? PROT_WRITE : 0);
+    int flags = anonymous ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED;
+    void* address = mmap(nullptr, size, protection, flags, anonymous ? -1 : fd, 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    base = static_cast<unsigned char*>(address);
+    mappedSize = size;
+    return true;
+}
+
+// Unmap and close
+void PopulationStore::close() {
+    if (base) {
+        munmap(base, mappedSize);
+        base = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// Create a new store sized for two generations
+bool PopulationStore::create(const std::string& filename, int numRecords, int numWeights,
+                             const std::vector<int>& topology, GenomePrecision precision) {
+    close();
+    if (numRecords <= 0 || numWeights <= 0 || topology.size() > MAX_LAYERS) {
+        return false;
+    }
+
+    this->numRecords = numRecords;
+    this->numWeights = numWeights;
+    this->topology = topology;
+    this->precision = precision;
+    size_t rawStride = sizeof(RecordHeader) + numWeights * genomeBytesPerWeight(precision);
+    recordStride = (rawStride + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+    size_t size = dataOffset + 2 * recordStride * static_cast<size_t>(numRecords);
+
+    if (filename.empty()) {
+        if (!map(size, true, true)) {
+            return false;
+        }
+    } else {
+        fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(size, true, false)) {
+            close();
+            return false;
+        }
+    }
+
+    FileHeader* fileHeader = reinterpret_cast<FileHeader*>(base);
+    std::memcpy(fileHeader->magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    fileHeader->version = STORE_VERSION;
+    fileHeader->numRecords = numRecords;
+    fileHeader->numWeights = numWeights;
+    fileHeader->recordStride = static_cast<uint32_t>(recordStride);
+    fileHeader->currentBuffer = 0;
+    fileHeader->numLayers = static_cast<uint32_t>(topology.size());
+    std::copy(topology.begin(), topology.end(), fileHeader->topology);
+    fileHeader->precision = static_cast<uint32_t>(precision);
+    return true;
+}
+
+// Open an existing store file
+bool PopulationStore::open(const std::string& filename) {
+    close();
+    fd = ::open(filename.c_str(), O_RDWR);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < dataOffset ||
+        !map(info.st_size, true, false)) {
+        close();
+        return false;
+    }
+
+    // Everything readGenome and record() rely on must hold, or a truncated
+    // or mismatched file would be read outside the mapping
+    const FileHeader* fileHeader = reinterpret_cast<const FileHeader*>(base);
+    if (!std::equal(fileHeader->magic, fileHeader->magic + 4, STORE_MAGIC) ||
+        fileHeader->version != STORE_VERSION ||
+        fileHeader->numLayers < 2 || fileHeader->numLayers > MAX_LAYERS ||
+        fileHeader->precision > static_cast<uint32_t>(GenomePrecision::BF16) ||
+        fileHeader->numRecords == 0 || fileHeader->numRecords > INT_MAX ||
+        fileHeader->numWeights == 0 || fileHeader->numWeights > INT_MAX ||
+        fileHeader->numWeights != topologyWeights(fileHeader->topology, fileHeader->numLayers) ||
+        fileHeader->currentBuffer > 1) {
+        close();
+        return false;
+    }
+    GenomePrecision filePrecision = static_cast<GenomePrecision>(fileHeader->precision);
+    size_t rawStride = sizeof(RecordHeader) +
+                       fileHeader->numWeights * genomeBytesPerWeight(filePrecision);
+    if (fileHeader->recordStride < rawStride ||
+        dataOffset + 2 * static_cast<size_t>(fileHeader->recordStride) * fileHeader->numRecords >
+            static_cast<size_t>(info.st_size)) {
+        close();
+        return false;
+    }
+
+    numRecords = fileHeader->numRecords;
+    numWeights = fileHeader->numWeights;
+    recordStride = fileHeader->recordStride;
+    precision = filePrecision;
+    topology.assign(fileHeader->topology, fileHeader->topology + fileHeader->numLayers);
+    return true;
+}
+
+int PopulationStore::current() const {
+    return static_cast<int>(reinterpret_cast<const FileHeader*>(base)->currentBuffer);
+}
+
+void PopulationStore::swapBuffers() {
+    reinterpret_cast<FileHeader*>(base)->currentBuffer = next();
+}
+
+// Address of a record
+unsigned char* PopulationStore::record(int buffer, int index) const {
+    return base + dataOffset + (static_cast<size_t>(buffer) * numRecords + index) * recordStride;
+}
+
+PopulationStore::RecordHeader& PopulationStore::header(int buffer, int index) {
+    return *reinterpret_cast<RecordHeader*>(record(buffer, index));
+}
+
+const PopulationStore::RecordHeader& PopulationStore::header(int buffer, int index) const {
+    return *reinterpret_cast<const RecordHeader*>(record(buffer, index));
+}
+
+// Copy a genome out of its record, widened to fp32
+void PopulationStore::readGenome(int buffer, int index, std::vector<float>& genome) const {
+    genome.resize(numWeights);
+    decodeGenome(record(buffer, index) + sizeof(RecordHeader), numWeights, precision, genome.data());
+}
+
+// Copy a genome into its record, rounded to the store's precision
+void PopulationStore::writeGenome(int buffer, int index, const std::vector<float>& genome) {
+    size_t count = std::min(genome.size(), static_cast<size_t>(numWeights));
+    encodeGenome(genome.data(), count, precision, record(buffer, index) + sizeof(RecordHeader));
+}
+
+// Copy a record between buffers
+void PopulationStore::copyRecord(int fromBuffer, int fromIndex, int toBuffer, int toIndex) {
+    std::memcpy(record(toBuffer, toIndex), record(fromBuffer, fromIndex), recordStride);
+}
+
+// madvise over the pages that cover records [begin, end)
+void PopulationStore::advise(int buffer, int begin, int end, int advice) const {
+    begin = std::max(0, begin);
+    end = std::min(numRecords, end);
+    if (begin >= end) {
+        return;
+    }
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t first = static_cast<size_t>(record(buffer, begin) - base) / pageSize * pageSize;
+    size_t last = static_cast<size_t>(record(buffer, end - 1) - base) + recordStride;
+    madvise(base + first, last - first, advice);
+}
+
+// Ask the kernel to start reading these records in
+void PopulationStore::prefetch(int buffer, int begin, int end) const {
+    advise(buffer, begin, end, MADV_WILLNEED);
+}
+
+// Drop these records from our resident set (the file keeps the data)
+void PopulationStore::release(int buffer, int begin, int end) const {
+    if (fd < 0) {
+        return;  // anonymous memory: MADV_DONTNEED would zero the records
+    }
+    // Only whole pages inside the range may be dropped; neighbours may be in use
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    begin = std::max(0, begin);
+    end = std::min(numRecords, end);
+    if (begin >= end) {
+        return;
+    }
+    size_t first = (static_cast<size_t>(record(buffer, begin) - base) + pageSize - 1) / pageSize * pageSize;
+    size_t last = static_cast<size_t>(record(buffer, end - 1) - base + recordStride) / pageSize * pageSize;
+    if (last > first) {
+        madvise(base + first, last - first, MADV_DONTNEED);
+    }
+}
+
+// Write dirty pages back
+void PopulationStore::sync() const {
+    if (base && fd >= 0) {
+        msync(base, mappedSize, MS_SYNC);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef POPULATION_STORE_H
+#define POPULATION_STORE_H
+
+#include "genome_codec.h"
+#include "memory_arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Out-of-core population storage
+// A memory-mapped file of fixed-stride genome records. The file holds two
+// generations (the current one and the one being bred), so a population is
+// bounded by disk rather than RAM. Callers stream over records in chunks and
+// use prefetch()/release() to keep only the working set resident.
+// Weights can be stored as fp16/bf16, halving record size; they are widened
+// to fp32 by readGenome().
+class PopulationStore {
+public:
+    // Per-record metadata, followed by the genome
+    struct RecordHeader {
+        uint64_t lineageId;  // unique id of this genome (kept by elites)
+        float fitness;
+        uint32_t reserved;
+    };
+
+    PopulationStore();
+    ~PopulationStore();
+
+    PopulationStore(const PopulationStore&) = delete;
+    PopulationStore& operator=(const PopulationStore&) = delete;
+
+    // Create (or overwrite) a store for numRecords genomes of numWeights weights
+    // An empty filename keeps the records in anonymous memory instead of a file.
+    bool create(const std::string& filename, int numRecords, int numWeights,
+                const std::vector<int>& topology,
+                GenomePrecision precision = GenomePrecision::FP32);
+
+    // Open an existing store (e.g. to watch a saved population)
+    bool open(const std::string& filename);
+
+    // Back in-memory stores created after this with huge pages, interleaved
+    // over the NUMA nodes (see memory_arena.h)
+    void setHugePages(bool enabled) { hugePages = enabled; }
+    PageKind getPageKind() const { return pageKind; }
+
+    int getNumRecords() const { return numRecords; }
+    int getNumWeights() const { return numWeights; }
+    GenomePrecision getPrecision() const { return precision; }
+    size_t getRecordBytes() const { return recordStride; }
+    const std::vector<int>& getTopology() const { return topology; }
+
+    // Generation buffers: 0/1. current() holds the evaluated population.
+    int current() const;
+    int next() const { return 1 - current(); }
+    void swapBuffers();
+
+    RecordHeader& header(int buffer, int index);
+    const RecordHeader& header(int buffer, int index) const;
+
+    // Genome access (flat layout of NeuralNetwork::getWeights, always fp32)
+    void readGenome(int buffer, int index, std::vector<float>& genome) const;
+    void writeGenome(int buffer, int index, const std::vector<float>& genome);
+
+    // Copy a whole record (header and genome) between buffers
+    void copyRecord(int fromBuffer, int fromIndex, int toBuffer, int toIndex);
+
+    // Paging hints for records [begin, end) of a buffer
+    void prefetch(int buffer, int begin, int end) const;
+    void release(int buffer, int begin, int end) const;
+
+    // Flush dirty pages to the file
+    void sync() const;
+
+private:
+    int fd;
+    unsigned char* base;
+    size_t mappedSize;
+    size_t recordStride;
+    size_t dataOffset;
+    int numRecords;
+    int numWeights;
+    GenomePrecision precision;
+    std::vector<int> topology;
+    bool hugePages;
+    PageKind pageKind;
+
+    unsigned char* record(int buffer, int index) const;
+    void advise(int buffer, int begin, int end, int advice) const;
+    bool map(size_t size, bool writable, bool anonymous);
+    void close();
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "rng.h"
+#include <cmath>
+#include <initializer_list>
+
+// SplitMix64: expands a seed into well-mixed state words
+static uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Ziggurat tables (Marsaglia & Tsang 2000), 128 layers
+namespace {
+
+struct ZigguratTables {
+    uint32_t kn[128];
+    float wn[128];
+    float fn[128];
+
+    ZigguratTables() {
+        const double m1 = 2147483648.0;
+        double dn = 3.442619855899;
+        double tn = dn;
+        const double vn = 9.91256303526217e-3;
+        double q = vn / std::exp(-0.5 * dn * dn);
+
+        kn[0] = static_cast<uint32_t>((dn / q) * m1);
+        kn[1] = 0;
+        wn[0] = static_cast<float>(q / m1);
+        wn[127] = static_cast<float>(dn / m1);
+        fn[0] = 1.0f;
+        fn[127] = static_cast<float>(std::exp(-0.5 * dn * dn));
+        for (int i = 126; i >= 1; i--) {
+            dn = std::sqrt(-2.0 * std::log(vn / dn + std::exp(-0.5 * dn * dn)));
+            kn[i + 1] = static_cast<uint32_t>((dn / tn) * m1);
+            tn = dn;
+            fn[i] = static_cast<float>(std::exp(-0.5 * dn * dn));
+            wn[i] = static_cast<float>(dn / m1);
+        }
+    }
+};
+
+const ZigguratTables zig;
+
+const float ZIGGURAT_R = 3.442620f;  // start of the tail
+
+} // namespace
+
+// Constructor: seed all lanes from one value
+Rng::Rng(uint64_t seed) {
+    seedLanes(seed);
+}
+
+// Constructor: keyed stream, the keys are hashed into the seed
+Rng::Rng(uint64_t seed, uint64_t key1, uint64_t key2, uint64_t key3) {
+    uint64_t x = seed;
+    uint64_t h = splitMix64(x);
+    for (uint64_t key : {key1, key2, key3}) {
+        x = h ^ key;
+        h = splitMix64(x);
+    }
+    seedLanes(h);
+}
+
+void Rng::seedLanes(uint64_t seed) {
+    uint64_t x = seed;
+    for (int lane = 0; lane < LANES; lane++) {
+        for (int word = 0; word < 4; word++) {
+            state[word][lane] = splitMix64(x);
+        }
+    }
+    position = LANES;
+}
+
+// One xoshiro256++ step of every lane (the loop body vectorizes)
+void Rng::step(uint64_t out[LANES]) {
+    for (int lane = 0; lane < LANES; lane++) {
+        uint64_t s0 = state[0][lane], s1 = state[1][lane];
+        uint64_t s2 = state[2][lane], s3 = state[3][lane];
+        out[lane] = rotl(s0 + s3, 23) + s0;
+        uint64_t t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rotl(s3, 45);
+        state[0][lane] = s0;
+        state[1][lane] = s1;
+        state[2][lane] = s2;
+        state[3][lane] = s3;
+    }
+}
+
+// Uniform integer in [0, bound)
+uint32_t Rng::below(uint32_t bound) {
+    uint64_t product = ((*this)() >> 32) * bound;
+    uint32_t low = static_cast<uint32_t>(product);
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = ((*this)() >> 32) * bound;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+// Slow path of the ziggurat: wedges and the tail (about 1.2% of draws)
+float Rng::normalTail(int32_t hz, int iz) {
+    for (;;) {
+        float x = hz * zig.wn[iz];
+        if (iz == 0) {
+            float y;
+            do {
+                x = -std::log(uniform() + 0x1.0p-25f) / ZIGGURAT_R;
+                y = -std::log(uniform() + 0x1.0p-25f);
+            } while (y + y < x * x);
+            return hz > 0 ? ZIGGURAT_R + x : -ZIGGURAT_R - x;
+        }
+        if (zig.fn[iz] + uniform() * (zig.fn[iz - 1] - zig.fn[iz]) < std::exp(-0.5f * x * x)) {
+            return x;
+        }
+        hz = static_cast<int32_t>((*this)() >> 32);
+        iz = hz & 127;
+        if (static_cast<uint32_t>(std::abs(static_cast<int64_t>(hz))) < zig.kn[iz]) {
+            return hz * zig.wn[iz];
+        }
+    }
+}
+
+// Standard normal
+float Rng::normal() {
+    int32_t hz = static_cast<int32_t>((*this)() >> 32);
+    int iz = hz & 127;
+    if (static_cast<uint32_t>(std::abs(static_cast<int64_t>(hz))) < zig.kn[iz]) {
+        return hz * zig.wn[iz];
+    }
+    return normalTail(hz, iz);
+}
+
+// Batch uniforms: two 24-bit floats from each 64-bit draw
+void Rng::fillUniform(float* out, size_t count) {
+    uint64_t bits[LANES];
+    size_t i = 0;
+    for (; i + 2 * LANES <= count; i += 2 * LANES) {
+        step(bits);
+        for (int lane = 0; lane < LANES; lane++) {
+            out[i + lane] = static_cast<float>(bits[lane] >> 40) * 0x1.0p-24f;
+            out[i + LANES + lane] = static_cast<float>((bits[lane] >> 8) & 0xffffff) * 0x1.0p-24f;
+        }
+    }
+    for (; i < count; i++) {
+        out[i] = uniform();
+    }
+}
+
+// Batch normals: two ziggurat candidates from each 64-bit draw
+void Rng::fillNormal(float* out, size_t count, float mean, float stddev) {
+    uint64_t bits[LANES];
+    size_t i = 0;
+    while (i + 2 * LANES <= count) {
+        step(bits);
+        for (int lane = 0; lane < LANES; lane++) {
+            for (int half = 0; half < 2; half++) {
+                int32_t hz = static_cast<int32_t>(half ? bits[lane] : bits[lane] >> 32);
+                int iz = hz & 127;
+                float x = static_cast<uint32_t>(std::abs(static_cast<int64_t>(hz))) < zig.kn[iz]
+                    ? hz * zig.wn[iz]
+                    : normalTail(hz, iz);
+                out[i++] = mean + stddev * x;
+            }
+        }
+    }
+    for (; i < count; i++) {
+        out[i] = mean + stddev * normal();
+    }
+}
+
+// Long jump (2^192 steps) of every lane
+void Rng::jump() {
+    static const uint64_t LONG_JUMP[4] = {
+        0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull
+    };
+    uint64_t result[4][LANES] = {};
+    for (uint64_t word : LONG_JUMP) {
+        for (int bit = 0; bit < 64; bit++) {
+            if (word & (uint64_t(1) << bit)) {
+                for (int s = 0; s < 4; s++) {
+                    for (int lane = 0; lane < LANES; lane++) {
+                        result[s][lane] ^= state[s][lane];
+                    }
+                }
+            }
+            uint64_t discard[LANES];
+            step(discard);
+        }
+    }
+    for (int s = 0; s < 4; s++) {
+        for (int lane = 0; lane < LANES; lane++) {
+            state[s][lane] = result[s][lane];
+        }
+    }
+    position = LANES;
+}
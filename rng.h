@@ -0,0 +1,63 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstddef>
+#include <cstdint>
+
+// xoshiro256++ random number generator
+// Four interleaved lanes, each an independent xoshiro256++ stream, are
+// stepped together so batch fills vectorize; scalar draws are served from
+// the last step. 128 bytes of state versus 5 KB for std::mt19937, and it
+// satisfies UniformRandomBitGenerator for use with <random> distributions.
+//
+// Keyed construction gives every (seed, key...) tuple its own stream, so
+// work split across threads can draw reproducibly without sharing state.
+class Rng {
+public:
+    using result_type = uint64_t;
+    static const int LANES = 4;
+
+    explicit Rng(uint64_t seed = 0);
+
+    // Stream for a key tuple, e.g. (runSeed, kind, generation, index)
+    Rng(uint64_t seed, uint64_t key1, uint64_t key2 = 0, uint64_t key3 = 0);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    // Next 64 random bits
+    result_type operator()() {
+        if (position == LANES) {
+            step(buffer);
+            position = 0;
+        }
+        return buffer[position++];
+    }
+
+    // Uniform integer in [0, bound) (Lemire's multiply-shift, unbiased)
+    uint32_t below(uint32_t bound);
+
+    // Uniform float in [0, 1) with 24 random bits
+    float uniform() { return static_cast<float>((*this)() >> 40) * 0x1.0p-24f; }
+
+    // Standard normal (ziggurat)
+    float normal();
+
+    // Batch draws
+    void fillUniform(float* out, size_t count);
+    void fillNormal(float* out, size_t count, float mean, float stddev);
+
+    // Advance every lane by 2^192 draws: a stream that never overlaps this one
+    void jump();
+
+private:
+    uint64_t state[4][LANES];  // state word, lane
+    uint64_t buffer[LANES];
+    int position;
+
+    void seedLanes(uint64_t seed);
+    void step(uint64_t out[LANES]);
+    float normalTail(int32_t hz, int iz);
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include "rng.h"
+#include "neural_network.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Statistical sanity checks and throughput of Rng against std::mt19937 with
+// the <random> distributions it replaces. Exits non-zero if a check fails.
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -n, --draws NUM           Draws per check and benchmark (default: 10000000)\n";
+    std::cout << "      --seed NUM            Random seed (default: 1)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+static int failures = 0;
+
+// Report a statistic against its expected value, failing beyond 5 standard errors
+static void check(const std::string& name, double value, double expected, double standardError) {
+    double z = (value - expected) / standardError;
+    bool pass = std::abs(z) < 5.0;
+    failures += pass ? 0 : 1;
+    std::cout << "  " << std::left << std::setw(34) << name << std::right
+              << std::setw(12) << std::setprecision(6) << value
+              << "  expected " << std::setw(10) << expected
+              << "  z = " << std::setw(6) << std::setprecision(2) << z
+              << (pass ? "  ok\n" : "  FAIL\n");
+}
+
+// Mean, variance, skewness, excess kurtosis and lag-1 correlation of a sample
+struct Moments {
+    double mean = 0, variance = 0, skewness = 0, kurtosis = 0, lagCorrelation = 0;
+
+    explicit Moments(const std::vector<float>& x) {
+        double n = static_cast<double>(x.size());
+        for (float v : x) {
+            mean += v;
+        }
+        mean /= n;
+        double m2 = 0, m3 = 0, m4 = 0, lag = 0;
+        for (size_t i = 0; i < x.size(); i++) {
+            double d = x[i] - mean;
+            m2 += d * d;
+            m3 += d * d * d;
+            m4 += d * d * d * d;
+            if (i > 0) {
+                lag += d * (x[i - 1] - mean);
+            }
+        }
+        variance = m2 / n;
+        skewness = (m3 / n) / std::pow(variance, 1.5);
+        kurtosis = (m4 / n) / (variance * variance) - 3.0;
+        lagCorrelation = lag / m2;
+    }
+};
+
+// Chi-square of a uniform sample over equal bins, as a z-score-ready value
+static double chiSquare(const std::vector<float>& x, int bins) {
+    std::vector<double> counts(bins, 0.0);
+    for (float v : x) {
+        counts[std::min(bins - 1, static_cast<int>(v * bins))] += 1.0;
+    }
+    double expected = static_cast<double>(x.size()) / bins;
+    double chi = 0.0;
+    for (double c : counts) {
+        chi += (c - expected) * (c - expected) / expected;
+    }
+    return chi;
+}
+
+static void checkUniform(const std::string& name, const std::vector<float>& x) {
+    double n = static_cast<double>(x.size());
+    Moments m(x);
+    std::cout << name << "\n";
+    check("mean", m.mean, 0.5, std::sqrt(1.0 / 12.0 / n));
+    check("variance", m.variance, 1.0 / 12.0, std::sqrt(1.0 / 180.0 / n));
+    check("lag-1 correlation", m.lagCorrelation, 0.0, 1.0 / std::sqrt(n));
+    const int BINS = 1000;
+    check("chi-square (1000 bins)", chiSquare(x, BINS), BINS - 1, std::sqrt(2.0 * (BINS - 1)));
+}
+
+static void checkNormal(const std::string& name, const std::vector<float>& x) {
+    double n = static_cast<double>(x.size());
+    Moments m(x);
+    double beyond3 = 0, beyond4 = 0;
+    for (float v : x) {
+        beyond3 += std::abs(v) > 3.0f;
+        beyond4 += std::abs(v) > 4.0f;
+    }
+    const double P3 = 2.699796e-3, P4 = 6.334248e-5;
+    std::cout << name << "\n";
+    check("mean", m.mean, 0.0, 1.0 / std::sqrt(n));
+    check("variance", m.variance, 1.0, std::sqrt(2.0 / n));
+    check("skewness", m.skewness, 0.0, std::sqrt(6.0 / n));
+    check("excess kurtosis", m.kurtosis, 0.0, std::sqrt(24.0 / n));
+    check("lag-1 correlation", m.lagCorrelation, 0.0, 1.0 / std::sqrt(n));
+    check("P(|x| > 3)", beyond3 / n, P3, std::sqrt(P3 * (1 - P3) / n));
+    check("P(|x| > 4)", beyond4 / n, P4, std::sqrt(P4 * (1 - P4) / n));
+}
+
+// Time a loop of count iterations, nanoseconds per iteration
+template <typename Body>
+static double timePerDraw(size_t count, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / count;
+}
+
+static void report(const std::string& name, double ns) {
+    std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed
+              << std::setw(8) << std::setprecision(2) << ns << " ns  "
+              << std::setw(8) << std::setprecision(0) << 1000.0 / ns << " M/s\n";
+    std::cout.unsetf(std::ios::fixed);
+}
+
+int main(int argc, char* argv[]) {
+    size_t draws = 10000000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-n" || arg == "--draws") {
+            if (i + 1 < argc) {
+                draws = std::stoull(argv[++i]);
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                seed = std::stoull(argv[++i]);
+            }
+        }
+    }
+
+    // 1. Sanity statistics
+    std::cout << "=== Statistical checks (" << draws << " draws) ===\n";
+    std::vector<float> x(draws);
+    Rng rng(seed);
+
+    for (auto& v : x) {
+        v = rng.uniform();
+    }
+    checkUniform("Rng::uniform", x);
+
+    rng.fillUniform(x.data(), x.size());
+    checkUniform("Rng::fillUniform", x);
+
+    for (auto& v : x) {
+        v = rng.normal();
+    }
+    checkNormal("Rng::normal", x);
+
+    rng.fillNormal(x.data(), x.size(), 0.0f, 1.0f);
+    checkNormal("Rng::fillNormal", x);
+
+    // Neighbouring keyed streams and jumped streams must be uncorrelated
+    {
+        std::vector<float> a(draws), b(draws), c(draws);
+        Rng streamA(seed, 1, 0, 0);
+        Rng streamB(seed, 1, 0, 1);
+        Rng jumped = streamA;
+        jumped.jump();
+        streamA.fillUniform(a.data(), draws);
+        streamB.fillUniform(b.data(), draws);
+        jumped.fillUniform(c.data(), draws);
+        double ab = 0, ac = 0;
+        for (size_t i = 0; i < draws; i++) {
+            ab += (a[i] - 0.5) * (b[i] - 0.5);
+            ac += (a[i] - 0.5) * (c[i] - 0.5);
+        }
+        double n = static_cast<double>(draws);
+        std::cout << "Stream independence\n";
+        check("keyed (.., 0) vs (.., 1)", ab / n * 12.0, 0.0, 1.0 / std::sqrt(n));
+        check("stream vs jump()", ac / n * 12.0, 0.0, 1.0 / std::sqrt(n));
+    }
+
+    // Unbiased bounded integers
+    {
+        const uint32_t BOUND = 7;
+        std::vector<double> counts(BOUND, 0.0);
+        for (size_t i = 0; i < draws; i++) {
+            counts[rng.below(BOUND)] += 1.0;
+        }
+        double expected = static_cast<double>(draws) / BOUND;
+        double chi = 0.0;
+        for (double c : counts) {
+            chi += (c - expected) * (c - expected) / expected;
+        }
+        std::cout << "Rng::below(7)\n";
+        check("chi-square (7 values)", chi, BOUND - 1, std::sqrt(2.0 * (BOUND - 1)));
+    }
+
+    // 2. Throughput
+    std::cout << "\n=== Throughput ===\n";
+    std::mt19937 mt(static_cast<unsigned int>(seed));
+    std::uniform_real_distribution<float> uniformDist(0.0f, 1.0f);
+    std::normal_distribution<float> normalDist(0.0f, 1.0f);
+    volatile float floatSink = 0.0f;
+    volatile uint64_t bitSink = 0;
+
+    report("std::mt19937 (32 bits)", timePerDraw(draws, [&]() {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < draws; i++) acc += mt();
+        bitSink = acc;
+    }));
+    report("Rng (64 bits)", timePerDraw(draws, [&]() {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < draws; i++) acc += rng();
+        bitSink = acc;
+    }));
+    report("uniform_real_distribution(mt19937)", timePerDraw(draws, [&]() {
+        float acc = 0;
+        for (size_t i = 0; i < draws; i++) acc += uniformDist(mt);
+        floatSink = acc;
+    }));
+    report("Rng::uniform", timePerDraw(draws, [&]() {
+        float acc = 0;
+        for (size_t i = 0; i < draws; i++) acc += rng.uniform();
+        floatSink = acc;
+    }));
+    report("Rng::fillUniform", timePerDraw(draws, [&]() {
+        rng.fillUniform(x.data(), x.size());
+        floatSink = x[draws / 2];
+    }));
+    report("normal_distribution(mt19937)", timePerDraw(draws, [&]() {
+        float acc = 0;
+        for (size_t i = 0; i < draws; i++) acc += normalDist(mt);
+        floatSink = acc;
+    }));
+    report("Rng::normal", timePerDraw(draws, [&]() {
+        float acc = 0;
+        for (size_t i = 0; i < draws; i++) acc += rng.normal();
+        floatSink = acc;
+    }));
+    report("Rng::fillNormal", timePerDraw(draws, [&]() {
+        rng.fillNormal(x.data(), x.size(), 0.0f, 1.0f);
+        floatSink = x[draws / 2];
+    }));
+
+    // Mutation of a trainer-sized network: the previous per-weight
+    // mt19937 draws against NeuralNetwork::mutate
+    std::vector<int> topology = {5, 8, 4, 1};
+    NeuralNetwork network(topology, mt);
+    std::vector<float> genome = network.getWeights();
+    size_t mutations = std::max<size_t>(1, draws / genome.size());
+    const float RATE = 0.1f, STRENGTH = 0.1f;
+    std::normal_distribution<float> noiseDist(0.0f, STRENGTH);
+    std::cout << "Mutation (" << genome.size() << " weights, rate " << RATE << ")\n";
+    report("per weight, mt19937 + <random>", timePerDraw(mutations * genome.size(), [&]() {
+        for (size_t m = 0; m < mutations; m++) {
+            for (auto& w : genome) {
+                if (uniformDist(mt) < RATE) {
+                    w += noiseDist(mt);
+                }
+            }
+        }
+        floatSink = genome[0];
+    }));
+    report("per weight, NeuralNetwork::mutate(Rng)", timePerDraw(mutations * genome.size(), [&]() {
+        for (size_t m = 0; m < mutations; m++) {
+            network.mutate(RATE, STRENGTH, rng);
+        }
+        floatSink = network.getWeights()[0];
+    }));
+
+    std::cout << "\n" << (failures == 0 ? "All checks passed" : "Some checks FAILED") << "\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+#include "evolution.h"
+#include "metrics.h"
+#include "simulation.h"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Scaling study of Evolution::evolve over population size, games per
+// evaluation, thread count, topology and population memory (the default
+// heap, or huge pages via memory_arena.h). Every point runs in its own forked
+// process so peak RSS (from wait4) belongs to that point alone.
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n";
+    std::cout << "Options (lists are comma separated):\n";
+    std::cout << "  -p, --populations LIST    Population sizes (default: 100,1000,10000,100000)\n";
+    std::cout << "  -e, --evaluations LIST    Games per evaluation (default: 1,5)\n";
+    std::cout << "  -j, --threads LIST        Thread counts (default: 1,2,4,... up to all cores)\n";
+    std::cout << "  -n, --topologies LIST     Topologies as layer sizes joined by '-' (default: 5-8-4-1)\n";
+    std::cout << "  -m, --memory LIST         Population memory: heap, huge (default: heap)\n";
+    std::cout << "  -g, --generations NUM     Generations per point (default: 2)\n";
+    std::cout << "      --seed NUM            Random seed (default: 1)\n";
+    std::cout << "  -o, --output FILE         CSV output (default: scaling.csv)\n";
+    std::cout << "  -h, --help                Show this help message\n";
+}
+
+// Split "a<sep>b<sep>c" into fields
+static std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> fields;
+    std::stringstream stream(text);
+    std::string field;
+    while (std::getline(stream, field, separator)) {
+        if (!field.empty()) {
+            fields.push_back(field);
+        }
+    }
+    return fields;
+}
+
+static std::vector<int> parseInts(const std::string& text) {
+    std::vector<int> values;
+    for (const auto& field : split(text, ',')) {
+        values.push_back(std::stoi(field));
+    }
+    return values;
+}
+
+// What a measurement process sends back to the driver
+struct PointResult {
+    double seconds;
+    uint64_t frames;
+    uint64_t games;
+};
+
+// Run one point in this process
+static PointResult runPoint(int populationSize, int gamesPerEvaluation, int numThreads,
+                            const std::vector<int>& topology, bool hugePages, int generations,
+                            unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> gapSize(150.0f, 250.0f);
+    std::uniform_real_distribution<float> gapY(200.0f, WINDOW_HEIGHT - 250.0f);
+
+    Evolution evolution(populationSize, topology, gamesPerEvaluation,
+                        0.1f, 0.1f, 0.2f, 3, gen, gapSize, gapY, "", GenomePrecision::FP32,
+                        hugePages);
+    evolution.setNumThreads(numThreads);
+
+    uint64_t framesBefore = getMetricTotal(Metric::FRAMES);
+    uint64_t gamesBefore = getMetricTotal(Metric::GAMES);
+    auto startTime = std::chrono::steady_clock::now();
+    for (int generation = 0; generation < generations; generation++) {
+        evolution.evolve();
+    }
+    PointResult result;
+    result.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime).count();
+    result.frames = getMetricTotal(Metric::FRAMES) - framesBefore;
+    result.games = getMetricTotal(Metric::GAMES) - gamesBefore;
+    return result;
+}
+
+// Run one point in a child process; peak RSS in KiB from wait4
+static bool runPointForked(int populationSize, int gamesPerEvaluation, int numThreads,
+                           const std::vector<int>& topology, bool hugePages, int generations,
+                           unsigned int seed,
+                           PointResult& result, long& peakRssKb) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        PointResult point = runPoint(populationSize, gamesPerEvaluation, numThreads,
+                                     topology, hugePages, generations, seed);
+        bool written = write(fds[1], &point, sizeof(point)) == static_cast<ssize_t>(sizeof(point));
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t received = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+        received != static_cast<ssize_t>(sizeof(result))) {
+        return false;
+    }
+    peakRssKb = usage.ru_maxrss;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> populations = {100, 1000, 10000, 100000};
+    std::vector<int> evaluations = {1, 5};
+    std::vector<int> threads;
+    std::vector<std::string> topologies = {"5-8-4-1"};
+    std::vector<std::string> memories = {"heap"};
+    int generations = 2;
+    unsigned int seed = 1;
+    std::string outputFile = "scaling.csv";
+
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 1; t < cores; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(cores);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "-p" || arg == "--populations") {
+            if (i + 1 < argc) {
+                populations = parseInts(argv[++i]);
+            }
+        } else if (arg == "-e" || arg == "--evaluations") {
+            if (i + 1 < argc) {
+                evaluations = parseInts(argv[++i]);
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            if (i + 1 < argc) {
+                threads = parseInts(argv[++i]);
+            }
+        } else if (arg == "-n" || arg == "--topologies") {
+            if (i + 1 < argc) {
+                topologies = split(argv[++i], ',');
+            }
+        } else if (arg == "-m" || arg == "--memory") {
+            if (i + 1 < argc) {
+                memories = split(argv[++i], ',');
+            }
+        } else if (arg == "-g" || arg == "--generations") {
+            if (i + 1 < argc) {
+                generations = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            }
+        } else if (arg == "-o" || arg == "--output") {
+            if (i + 1 < argc) {
+                outputFile = argv[++i];
+            }
+        }
+    }
+
+    for (const auto& memory : memories) {
+        if (memory != "heap" && memory != "huge") {
+            std::cerr << "Error: unknown population memory " << memory << "\n";
+            return 1;
+        }
+    }
+
+    std::ofstream csv(outputFile);
+    if (!csv) {
+        std::cerr << "Error: could not write " << outputFile << "\n";
+        return 1;
+    }
+    csv << "topology,population,games_per_evaluation,threads,generations,seconds,"
+           "frames_per_second,agents_per_second,peak_rss_mb,parallel_efficiency,memory\n";
+
+    std::cout << std::fixed;
+    std::cout << "  topology  population games threads    seconds   frames/s   agents/s  RSS (MB)  efficiency  memory\n";
+
+    // Single-thread (or lowest thread count) rate per (topology, population, games, memory)
+    std::map<std::tuple<std::string, int, int, std::string>, std::pair<int, double>> baseline;
+
+    for (const auto& topologyName : topologies) {
+        std::vector<int> topology;
+        for (const auto& layer : split(topologyName, '-')) {
+            topology.push_back(std::stoi(layer));
+        }
+        if (topology.size() < 2 || topology[0] != 5 || topology.back() != 1) {
+            std::cerr << "Error: topology " << topologyName << " must start with 5 and end with 1\n";
+            return 1;
+        }
+
+        for (int populationSize : populations) {
+            for (int games : evaluations) {
+                for (int numThreads : threads) {
+                    for (const auto& memory : memories) {
+                        PointResult result;
+                        long peakRssKb = 0;
+                        if (!runPointForked(populationSize, games, numThreads, topology, memory == "huge",
+                                            generations, seed, result, peakRssKb)) {
+                            std::cerr << "Error: point " << topologyName << " p=" << populationSize
+                                      << " e=" << games << " j=" << numThreads << " " << memory
+                                      << " failed\n";
+                            continue;
+                        }
+
+                        double framesPerSecond = result.frames / result.seconds;
+                        double agentsPerSecond = result.games / static_cast<double>(games) / result.seconds;
+
+                        // Efficiency: speedup over the baseline divided by the thread ratio
+                        auto key = std::make_tuple(topologyName, populationSize, games, memory);
+                        auto base = baseline.find(key);
+                        if (base == baseline.end()) {
+                            base = baseline.emplace(key, std::make_pair(numThreads, framesPerSecond)).first;
+                        }
+                        double efficiency = (framesPerSecond / base->second.second) /
+                                            (static_cast<double>(numThreads) / base->second.first);
+
+                        csv << topologyName << "," << populationSize << "," << games << ","
+                            << numThreads << "," << generations << "," << result.seconds << ","
+                            << framesPerSecond << "," << agentsPerSecond << ","
+                            << peakRssKb / 1024.0 << "," << efficiency << "," << memory << "\n";
+                        csv.flush();
+
+                        std::cout << std::setw(10) << topologyName << std::setw(12) << populationSize
+                                  << std::setw(6) << games << std::setw(8) << numThreads
+                                  << std::setw(11) << std::setprecision(2) << result.seconds
+                                  << std::setw(11) << std::setprecision(0) << framesPerSecond
+                                  << std::setw(11) << agentsPerSecond
+                                  << std::setw(10) << std::setprecision(1) << peakRssKb / 1024.0
+                                  << std::setw(12) << std::setprecision(2) << efficiency
+                                  << "  " << memory << "\n";
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "\nResults written to " << outputFile << "\n";
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "scheduler.h"
+#include "alloc_profiler.h"
+#include <algorithm>
+
+// Constructor: start numThreads - 1 helper threads (worker 0 is the caller)
+WorkStealingScheduler::WorkStealingScheduler(int numThreads)
+    : numThreads(std::max(1, numThreads)) {
+    for (int i = 0; i < this->numThreads; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 1; i < this->numThreads; i++) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this, i);
+    }
+}
+
+// Destructor: wake helpers and wait for them to exit
+WorkStealingScheduler::~WorkStealingScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Run all tasks to completion
+void WorkStealingScheduler::run(std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    // Deal tasks round-robin so every worker starts with a local slice
+    pending.fetch_add(static_cast<long long>(tasks.size()));
+    for (size_t i = 0; i < tasks.size(); i++) {
+        WorkerQueue& queue = *queues[i % numThreads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(tasks[i]));
+    }
+    queued.fetch_add(static_cast<long long>(tasks.size()));
+    tasks.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        batch++;
+        batchPhase = currentAllocPhase();
+        activeWorkers = numThreads - 1;
+    }
+    wakeCondition.notify_all();
+
+    workUntilDone(0);
+
+    // Wait for helpers to go back to sleep before returning to the caller
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+}
+
+// Push a task onto a worker's own deque
+void WorkStealingScheduler::push(int worker, Task task, bool front) {
+    pending.fetch_add(1);
+    WorkerQueue& queue = *queues[worker];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (front) {
+            queue.tasks.push_front(std::move(task));
+        } else {
+            queue.tasks.push_back(std::move(task));
+        }
+    }
+    queued.fetch_add(1);
+    wakeIdle();
+}
+
+// Pop from the back of our own deque
+bool WorkStealingScheduler::popLocal(int worker, Task& task) {
+    WorkerQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queued.fetch_sub(1);
+    return true;
+}
+
+// Steal from the front of another worker's deque
+bool WorkStealingScheduler::steal(int worker, Task& task) {
+    for (int offset = 1; offset < numThreads; offset++) {
+        WorkerQueue& queue = *queues[(worker + offset) % numThreads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Wake parked workers. Taking the mutex orders this after a worker's check
+// of its wait condition, so a wakeup can't slip in between check and wait.
+void WorkStealingScheduler::wakeIdle() {
+    if (idleWorkers.load() > 0) {
+        { std::lock_guard<std::mutex> lock(idleMutex); }
+        idleCondition.notify_all();
+    }
+}
+
+// Execute tasks until none are queued or running anywhere
+void WorkStealingScheduler::workUntilDone(int worker) {
+    Task task;
+    while (pending.load() > 0) {
+        if (popLocal(worker, task) || steal(worker, task)) {
+            task(worker);
+            task = nullptr;
+            if (pending.fetch_sub(1) == 1) {
+                wakeIdle();
+            }
+        } else {
+            // Everything left is running elsewhere: sleep instead of spinning
+            idleWorkers.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> lock(idleMutex);
+                idleCondition.wait(lock, [this] { return queued.load() > 0 || pending.load() == 0; });
+            }
+            idleWorkers.fetch_sub(1);
+        }
+    }
+}
+
+// Helper thread: sleep until a batch arrives, then work on it
+void WorkStealingScheduler::workerLoop(int worker) {
+    unsigned long long seenBatch = 0;
+    while (true) {
+        const char* phase;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait(lock, [&] { return stopping || batch != seenBatch; });
+            if (stopping) {
+                return;
+            }
+            seenBatch = batch;
+            phase = batchPhase;
+        }
+
+        {
+            ALLOC_PHASE(phase);
+            workUntilDone(worker);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            activeWorkers--;
+        }
+        doneCondition.notify_all();
+    }
+}
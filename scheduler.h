@@ -0,0 +1,71 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing task scheduler
+// Each worker owns a deque: it pops its own work from the back (LIFO) and
+// steals from the front of other workers' deques (FIFO) when it runs dry.
+// The calling thread takes part as worker 0, so numThreads == 1 runs inline.
+class WorkStealingScheduler {
+public:
+    // A task receives the index of the worker running it
+    using Task = std::function<void(int worker)>;
+
+    explicit WorkStealingScheduler(int numThreads);
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    // Run all tasks (and anything they push) to completion
+    void run(std::vector<Task>& tasks);
+
+    // Push a task from inside a running task. Tasks pushed to the front are
+    // the first to be stolen and the last the owning worker gets back to.
+    void push(int worker, Task task, bool front = false);
+
+    int getNumThreads() const { return numThreads; }
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    int numThreads;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<long long> pending{0};  // tasks queued or running
+    std::atomic<long long> queued{0};   // tasks sitting in a deque
+
+    // Workers that found nothing to run park here until a task is pushed or
+    // the batch finishes
+    std::mutex idleMutex;
+    std::condition_variable idleCondition;
+    std::atomic<int> idleWorkers{0};
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    unsigned long long batch = 0;  // incremented for every run()
+    const char* batchPhase = nullptr;  // allocation phase of the caller of run()
+    int activeWorkers = 0;
+    bool stopping = false;
+
+    bool popLocal(int worker, Task& task);
+    bool steal(int worker, Task& task);
+    void wakeIdle();
+    void workUntilDone(int worker);
+    void workerLoop(int worker);
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "score_stats.h"
+#include <algorithm>
+#include <cmath>
+
+void RunningStats::add(double value) {
+    count++;
+    if (count == 1) {
+        min = max = value;
+    } else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+// Chan et al.'s pairwise combination of two Welford accumulators
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    uint64_t total = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta * other.count / total;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    count = total;
+}
+
+double RunningStats::getVariance() const {
+    return count > 1 ? m2 / (count - 1) : 0.0;
+}
+
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+    : gamma((1.0 + relativeAccuracy) / (1.0 - relativeAccuracy)), logGamma(std::log(gamma)) {
+}
+
+int QuantileSketch::bucketIndex(double value) const {
+    return static_cast<int>(std::ceil(std::log(value) / logGamma));
+}
+
+// Buckets are one contiguous run, widened at either end on demand
+void QuantileSketch::addToBucket(int index, uint64_t amount) {
+    if (buckets.empty()) {
+        firstBucket = index;
+        buckets.push_back(0);
+    } else if (index < firstBucket) {
+        buckets.insert(buckets.begin(), firstBucket - index, 0);
+        firstBucket = index;
+    } else if (index >= firstBucket + static_cast<int>(buckets.size())) {
+        buckets.resize(index - firstBucket + 1, 0);
+    }
+    buckets[index - firstBucket] += amount;
+}
+
+void QuantileSketch::add(double value) {
+    count++;
+    if (value <= 0.0) {
+        zeros++;
+        return;
+    }
+    addToBucket(bucketIndex(value), 1);
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    count += other.count;
+    zeros += other.zeros;
+    for (size_t i = 0; i < other.buckets.size(); i++) {
+        if (other.buckets[i] > 0) {
+            addToBucket(other.firstBucket + static_cast<int>(i), other.buckets[i]);
+        }
+    }
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * (count - 1));
+    if (rank < zeros) {
+        return 0.0;
+    }
+    uint64_t seen = zeros;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            // Midpoint (in relative terms) of [gamma^(index-1), gamma^index)
+            return 2.0 * std::pow(gamma, firstBucket + static_cast<int>(i)) / (gamma + 1.0);
+        }
+    }
+    return 2.0 * std::pow(gamma, firstBucket + static_cast<int>(buckets.size()) - 1) / (gamma + 1.0);
+}
+
+void ScoreStats::add(const GameResult& result) {
+    score.add(result.score);
+    frames.add(result.framesAlive);
+    fitness.add(result.fitness());
+    scoreQuantiles.add(result.score);
+    frameQuantiles.add(result.framesAlive);
+    causes[static_cast<int>(result.cause)]++;
+}
+
+void ScoreStats::merge(const ScoreStats& other) {
+    score.merge(other.score);
+    frames.merge(other.frames);
+    fitness.merge(other.fitness);
+    scoreQuantiles.merge(other.scoreQuantiles);
+    frameQuantiles.merge(other.frameQuantiles);
+    for (int i = 0; i < 5; i++) {
+        causes[i] += other.causes[i];
+    }
+}
+
+const char* crashCauseName(CrashCause cause) {
+    switch (cause) {
+        case CrashCause::CEILING: return "ceiling";
+        case CrashCause::FLOOR: return "floor";
+        case CrashCause::TOP_PIPE: return "top pipe";
+        case CrashCause::BOTTOM_PIPE: return "bottom pipe";
+        default: return "none";
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef SCORE_STATS_H
+#define SCORE_STATS_H
+
+#include "simulation.h"
+#include <cstdint>
+#include <vector>
+
+// Streaming mean and variance (Welford), mergeable across threads
+class RunningStats {
+public:
+    void add(double value);
+    void merge(const RunningStats& other);
+
+    uint64_t getCount() const { return count; }
+    double getMean() const { return mean; }
+    double getVariance() const;  // sample variance
+    double getMin() const { return min; }
+    double getMax() const { return max; }
+
+private:
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;  // sum of squared deviations from the mean
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Quantile sketch with relative accuracy (DDSketch): non-negative values
+// fall into logarithmic buckets [gamma^(i-1), gamma^i), so any quantile is
+// returned within relativeAccuracy of a true value of that rank. Zero has
+// its own bucket. Memory grows with log(max / min value), not with the
+// number of values, and sketches with the same accuracy merge exactly.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.01);
+
+    void add(double value);
+    void merge(const QuantileSketch& other);
+
+    // Value at quantile q in [0, 1] (0 if empty)
+    double quantile(double q) const;
+
+    uint64_t getCount() const { return count; }
+    size_t getNumBuckets() const { return buckets.size(); }
+
+private:
+    double gamma;
+    double logGamma;
+    uint64_t count = 0;
+    uint64_t zeros = 0;            // values <= 0
+    int firstBucket = 0;           // index of buckets[0]
+    std::vector<uint64_t> buckets;
+
+    int bucketIndex(double value) const;
+    void addToBucket(int index, uint64_t amount);
+};
+
+// Everything the eval tool reports about a batch of games
+struct ScoreStats {
+    RunningStats score;
+    RunningStats frames;
+    RunningStats fitness;
+    QuantileSketch scoreQuantiles;
+    QuantileSketch frameQuantiles;
+    uint64_t causes[5] = {};  // games per CrashCause (NONE = reached maxFrames)
+
+    explicit ScoreStats(double relativeAccuracy = 0.01)
+        : scoreQuantiles(relativeAccuracy), frameQuantiles(relativeAccuracy) {}
+
+    void add(const GameResult& result);
+    void merge(const ScoreStats& other);
+};
+
+// Lower-case name of a crash cause ("ceiling", "bottom pipe", ...)
+const char* crashCauseName(CrashCause cause);
+
+#endif
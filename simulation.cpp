@@ -1,5 +1,7 @@
 #include "simulation.h"
 #include "game_types.h"
+#include "metrics.h"
+#include "alloc_profiler.h"
 #include <algorithm>
 #include <cmath>
 
@@ -15,10 +17,19 @@ struct Rect {
     }
 };
 
+// Pipes alive at once: each lives (WINDOW_WIDTH + PIPE_WIDTH) / SCROLL_SPEED
+// = 430 frames and one spawns every 120 frames
+const size_t MAX_PIPES_ON_SCREEN = 4;
+
 // Extract game state features for neural network input
 std::vector<float> extractFeatures(const Bird& bird, const std::vector<Pipe>& pipes) {
     std::vector<float> features(5);
-    
+    extractFeatures(bird, pipes, features.data());
+    return features;
+}
+
+// Extract game state features into an array
+void extractFeatures(const Bird& bird, const std::vector<Pipe>& pipes, float features[5]) {
     // Normalize bird y position (0-1)
     features[0] = bird.y / (WINDOW_HEIGHT - 50.0f);
     
@@ -47,15 +58,21 @@ std::vector<float> extractFeatures(const Bird& bird, const std::vector<Pipe>& pi
     
     // Vertical distance from bird to gap center (normalized)
     features[4] = (bird.y - gapY) / (WINDOW_HEIGHT - 50.0f);
-    
-    return features;
 }
 
 // Check if bird collides with pipes or boundaries
 bool checkCollision(const Bird& bird, const std::vector<Pipe>& pipes) {
+    return collisionCause(bird, pipes) != CrashCause::NONE;
+}
+
+// Classify the collision, if any
+CrashCause collisionCause(const Bird& bird, const std::vector<Pipe>& pipes) {
     // Check boundaries
-    if (bird.y < 0 || bird.y + BIRD_SIZE * 2 > WINDOW_HEIGHT - 50) {
-        return true;
+    if (bird.y < 0) {
+        return CrashCause::CEILING;
+    }
+    if (bird.y + BIRD_SIZE * 2 > WINDOW_HEIGHT - 50) {
+        return CrashCause::FLOOR;
     }
     
     // Check pipe collisions
@@ -69,7 +86,7 @@ bool checkCollision(const Bird& bird, const std::vector<Pipe>& pipes) {
         if (gapTop > 0) {
             Rect topPipeRect = {pipe.x, 0.0f, PIPE_WIDTH, gapTop};
             if (birdRect.intersects(topPipeRect)) {
-                return true;
+                return CrashCause::TOP_PIPE;
             }
         }
         
@@ -78,45 +95,48 @@ bool checkCollision(const Bird& bird, const std::vector<Pipe>& pipes) {
             float bottomPipeHeight = (WINDOW_HEIGHT - 50) - gapBottom;
             Rect bottomPipeRect = {pipe.x, gapBottom, PIPE_WIDTH, bottomPipeHeight};
             if (birdRect.intersects(bottomPipeRect)) {
-                return true;
+                return CrashCause::BOTTOM_PIPE;
             }
         }
     }
     
-    return false;
+    return CrashCause::NONE;
 }
 
-// Headless game simulation
-GameResult simulateGame(
-    std::mt19937& gen,
-    std::uniform_real_distribution<float>& gapSize,
-    std::uniform_real_distribution<float>& gapY,
-    std::function<bool(const std::vector<float>&)> shouldFlap,
-    int maxFrames) {
-    
-    // Initialize game state
-    Bird bird;
+// Resumable game: initialize state
+GameSession::GameSession(int maxFrames)
+    : score(0), frames(0), pipeSpawnCounter(0), maxFrames(maxFrames), finished(false) {
+    pipes.reserve(MAX_PIPES_ON_SCREEN);
     bird.x = 100.0f;
     bird.y = WINDOW_HEIGHT / 2.0f;
     bird.vx = 0.0f;
     bird.vy = 0.0f;
     
-    std::vector<Pipe> pipes;
-    int score = 0;
-    int frames = 0;
-    int pipeSpawnCounter = 0;
-    const int PIPE_SPAWN_INTERVAL = 120;
-    
-    GameResult result;
     result.crashed = false;
+    result.cause = CrashCause::NONE;
     result.framesAlive = 0;
     result.score = 0;
     result.distanceTraveled = 0.0f;
+}
+
+// Resumable game: simulate up to frameBudget frames
+bool GameSession::advance(
+    std::mt19937& gen,
+    std::uniform_real_distribution<float>& gapSize,
+    std::uniform_real_distribution<float>& gapY,
+    const std::function<bool(const std::vector<float>&)>& shouldFlap,
+    int frameBudget) {
     
-    // Game loop
-    while (frames < maxFrames && !result.crashed) {
+    ALLOC_PHASE("simulateGame");
+    const int PIPE_SPAWN_INTERVAL = 120;
+    int chunkStart = frames;
+    int chunkEnd = frames + std::min(frameBudget, maxFrames - frames);
+    
+    // Game loop; one feature vector for the whole chunk
+    std::vector<float> features(5);
+    while (frames < chunkEnd && !result.crashed) {
         // Extract features and get decision from agent
-        auto features = extractFeatures(bird, pipes);
+        extractFeatures(bird, pipes, features.data());
         bool flap = shouldFlap(features);
         
         if (flap) {
@@ -129,8 +149,10 @@ GameResult simulateGame(
         bird.x += bird.vx;
         
         // Check collision
-        if (checkCollision(bird, pipes)) {
+        CrashCause cause = collisionCause(bird, pipes);
+        if (cause != CrashCause::NONE) {
             result.crashed = true;
+            result.cause = cause;
             result.framesAlive = frames;
             result.score = score;
             result.distanceTraveled = bird.x;
@@ -170,13 +192,33 @@ GameResult simulateGame(
         frames++;
     }
     
-    // Game completed without crashing
-    if (!result.crashed) {
+    if (result.crashed) {
+        finished = true;
+    } else if (frames >= maxFrames) {
+        // Game completed without crashing
         result.framesAlive = frames;
         result.score = score;
         result.distanceTraveled = bird.x;
+        finished = true;
+    }
+    
+    countMetric(Metric::FRAMES, frames - chunkStart + (result.crashed ? 1 : 0));
+    if (finished) {
+        countMetric(Metric::GAMES);
     }
     
-    return result;
+    return finished;
 }
 
+// Headless game simulation
+GameResult simulateGame(
+    std::mt19937& gen,
+    std::uniform_real_distribution<float>& gapSize,
+    std::uniform_real_distribution<float>& gapY,
+    std::function<bool(const std::vector<float>&)> shouldFlap,
+    int maxFrames) {
+    
+    GameSession session(maxFrames);
+    session.advance(gen, gapSize, gapY, shouldFlap, maxFrames);
+    return session.getResult();
+}
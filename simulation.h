@@ -6,11 +6,21 @@
 #include <random>
 #include <functional>
 
+// What ended a game (checked in this order)
+enum class CrashCause {
+    NONE,
+    CEILING,
+    FLOOR,
+    TOP_PIPE,
+    BOTTOM_PIPE
+};
+
 struct GameResult {
     int score;
     float distanceTraveled;
     int framesAlive;
     bool crashed;
+    CrashCause cause = CrashCause::NONE;
     
     // Fitness function for evolutionary algorithm
     float fitness() const {
@@ -21,6 +31,36 @@ struct GameResult {
 // Forward declaration for NeuralNetwork (if needed)
 class NeuralNetwork;
 
+// Resumable headless game: holds the state of one game so it can be
+// simulated in chunks of frames (e.g. by different worker threads)
+class GameSession {
+private:
+    Bird bird;
+    std::vector<Pipe> pipes;
+    int score;
+    int frames;
+    int pipeSpawnCounter;
+    int maxFrames;
+    bool finished;
+    GameResult result;
+    
+public:
+    explicit GameSession(int maxFrames = 10000);
+    
+    // Simulate up to frameBudget more frames; returns true once the game is over
+    bool advance(std::mt19937& gen,
+                 std::uniform_real_distribution<float>& gapSize,
+                 std::uniform_real_distribution<float>& gapY,
+                 const std::function<bool(const std::vector<float>&)>& shouldFlap,
+                 int frameBudget);
+    
+    bool isFinished() const { return finished; }
+    int getFrames() const { return frames; }
+    
+    // Final result (only meaningful once isFinished())
+    const GameResult& getResult() const { return result; }
+};
+
 // Headless game simulation
 // shouldFlap: function that takes features and returns true if bird should flap
 // maxFrames: maximum number of frames to simulate (prevents infinite loops)
@@ -34,4 +74,13 @@ GameResult simulateGame(
 // Extract game state features for neural network input
 std::vector<float> extractFeatures(const Bird& bird, const std::vector<Pipe>& pipes);
 
+// Same features written into a caller-provided array (no allocation)
+void extractFeatures(const Bird& bird, const std::vector<Pipe>& pipes, float features[5]);
+
+// True if the bird hits the ceiling, the ground or a pipe
+bool checkCollision(const Bird& bird, const std::vector<Pipe>& pipes);
+
+// Which of them it hits (CrashCause::NONE if none)
+CrashCause collisionCause(const Bird& bird, const std::vector<Pipe>& pipes);
+
 #endif
\ No newline at end of file
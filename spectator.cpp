@@ -0,0 +1,345 @@
+#include "spectator.h"
+#include "population_store.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+// Texture: a circle on transparent background; its centre is a solid texel
+static const unsigned int TEXTURE_SIZE = 64;
+
+// Load the population, best agents first
+bool Spectator::load(const std::string& populationFile, int birds) {
+    PopulationStore store;
+    if (!store.open(populationFile) || store.getNumRecords() == 0) {
+        return false;
+    }
+    int buffer = store.current();
+    int numRecords = store.getNumRecords();
+    std::vector<int> order(numRecords);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return store.header(buffer, a).fitness > store.header(buffer, b).fitness;
+    });
+
+    int count = birds > 0 ? birds : numRecords;
+    flock = std::make_unique<Flock>(store.getTopology());
+    rankShade.resize(count);
+    std::vector<float> genome;
+    for (int i = 0; i < count; i++) {
+        store.readGenome(buffer, order[i % numRecords], genome);
+        flock->addGenome(genome);
+        rankShade[i] = static_cast<float>(i % numRecords) / std::max(1, numRecords - 1);
+    }
+
+    // Ground, top and bottom of every pipe, then the birds
+    vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
+    vertices.resize(static_cast<size_t>(1 + 2 * MAX_PIPES + count) * VERTICES_PER_QUAD);
+    buildTexture();
+    return true;
+}
+
+// Anti-aliased circle filling the texture
+void Spectator::buildTexture() {
+    sf::Image image(sf::Vector2u(TEXTURE_SIZE, TEXTURE_SIZE), sf::Color::Transparent);
+    float centre = TEXTURE_SIZE / 2.0f;
+    float radius = centre - 1.0f;
+    for (unsigned int y = 0; y < TEXTURE_SIZE; y++) {
+        for (unsigned int x = 0; x < TEXTURE_SIZE; x++) {
+            float distance = std::hypot(x + 0.5f - centre, y + 0.5f - centre);
+            float coverage = std::max(0.0f, std::min(1.0f, radius - distance + 0.5f));
+            image.setPixel(sf::Vector2u(x, y),
+                           sf::Color(255, 255, 255, static_cast<uint8_t>(coverage * 255.0f)));
+        }
+    }
+    if (!texture.loadFromImage(image)) {
+        std::cerr << "Warning: could not create bird texture\n";
+    }
+    texture.setSmooth(true);
+}
+
+// Write one quad as two triangles
+void Spectator::setQuad(int quad, float x, float y, float width, float height,
+                        sf::Color color, bool textured) {
+    sf::Vertex* v = &vertices[static_cast<size_t>(quad) * VERTICES_PER_QUAD];
+    sf::Vector2f topLeft(x, y), topRight(x + width, y);
+    sf::Vector2f bottomLeft(x, y + height), bottomRight(x + width, y + height);
+    float size = static_cast<float>(TEXTURE_SIZE);
+    sf::Vector2f solid(size / 2.0f, size / 2.0f);
+
+    v[0].position = topLeft;
+    v[1].position = topRight;
+    v[2].position = bottomLeft;
+    v[3].position = topRight;
+    v[4].position = bottomRight;
+    v[5].position = bottomLeft;
+    v[0].texCoords = textured ? sf::Vector2f(0.0f, 0.0f) : solid;
+    v[1].texCoords = textured ? sf::Vector2f(size, 0.0f) : solid;
+    v[2].texCoords = textured ? sf::Vector2f(0.0f, size) : solid;
+    v[3].texCoords = v[1].texCoords;
+    v[4].texCoords = textured ? sf::Vector2f(size, size) : solid;
+    v[5].texCoords = v[2].texCoords;
+    for (int i = 0; i < VERTICES_PER_QUAD; i++) {
+        v[i].color = color;
+    }
+}
+
+// Collapse a quad to nothing (it stays in the array)
+void Spectator::hideQuad(int quad) {
+    sf::Vertex* v = &vertices[static_cast<size_t>(quad) * VERTICES_PER_QUAD];
+    for (int i = 0; i < VERTICES_PER_QUAD; i++) {
+        v[i].position = sf::Vector2f(0.0f, 0.0f);
+    }
+}
+
+// Rewrite every quad from the flock's state
+void Spectator::updateVertices() {
+    const float groundY = WINDOW_HEIGHT - 50.0f;
+    setQuad(0, 0.0f, groundY, WINDOW_WIDTH, 50.0f, sf::Color(34, 139, 34), false);
+
+    const auto& pipes = flock->getPipes();
+    const sf::Color pipeColor(0, 150, 0);
+    for (int i = 0; i < MAX_PIPES; i++) {
+        int top = 1 + 2 * i;
+        if (i >= static_cast<int>(pipes.size())) {
+            hideQuad(top);
+            hideQuad(top + 1);
+            continue;
+        }
+        const Pipe& pipe = pipes[i];
+        float gapTop = pipe.gapY - pipe.gap / 2;
+        float gapBottom = pipe.gapY + pipe.gap / 2;
+        if (gapTop > 0) {
+            setQuad(top, pipe.x, 0.0f, PIPE_WIDTH, gapTop, pipeColor, false);
+        } else {
+            hideQuad(top);
+        }
+        if (gapBottom < groundY) {
+            setQuad(top + 1, pipe.x, gapBottom, PIPE_WIDTH, groundY - gapBottom, pipeColor, false);
+        } else {
+            hideQuad(top + 1);
+        }
+    }
+
+    // Best agents last so they are drawn on top; yellow fading to white by rank
+    int firstBird = 1 + 2 * MAX_PIPES;
+    int count = flock->size();
+    for (int i = 0; i < count; i++) {
+        int quad = firstBird + count - 1 - i;
+        if (!flock->isAlive(i)) {
+            hideQuad(quad);
+            continue;
+        }
+        const Bird& bird = flock->getBird(i);
+        float shade = rankShade[i];
+        sf::Color color(255, static_cast<uint8_t>(200 + 55 * shade),
+                        static_cast<uint8_t>(255 * shade), static_cast<uint8_t>(230 - 130 * shade));
+        setQuad(quad, bird.x, bird.y, BIRD_SIZE * 2, BIRD_SIZE * 2, color, true);
+    }
+}
+
+// Round loop
+void Spectator::run(sf::RenderWindow& window, const sf::Font& font, unsigned int seed) {
+    sf::Text hud(font, "", 24);
+    hud.setPosition(sf::Vector2f(10.0f, 10.0f));
+    hud.setFillColor(sf::Color::White);
+    hud.setOutlineColor(sf::Color::Black);
+    hud.setOutlineThickness(2.0f);
+    std::string hudString;
+
+    unsigned int round = 0;
+    flock->reset(seed);
+
+    sf::Clock fpsClock;
+    int fpsFrames = 0;
+    int fps = 0;
+    const sf::RenderStates states(&texture);
+
+    while (window.isOpen()) {
+        bool newRound = false;
+        while (auto event = window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                window.close();
+            }
+            if (auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+                newRound = newRound || keyPressed->code == sf::Keyboard::Key::Space;
+            }
+        }
+
+        if (!flock->step() || newRound) {
+            int best = 0;
+            for (int i = 1; i < flock->size(); i++) {
+                if (flock->getResult(i).framesAlive > flock->getResult(best).framesAlive) {
+                    best = i;
+                }
+            }
+            std::cout << "Round " << round << ": score " << flock->getScore() << ", longest flight "
+                      << flock->getResult(best).framesAlive << " frames (agent rank " << best << "), "
+                      << fps << " fps\n";
+            round++;
+            flock->reset(seed + round);
+        }
+        updateVertices();
+
+        fpsFrames++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 0.5f) {
+            fps = static_cast<int>(std::lround(fpsFrames / fpsClock.restart().asSeconds()));
+            fpsFrames = 0;
+        }
+        std::string text = "Round " + std::to_string(round) + "   Alive " +
+                           std::to_string(flock->getAlive()) + "/" + std::to_string(flock->size()) +
+                           "   Score " + std::to_string(flock->getScore()) + "   " +
+                           std::to_string(fps) + " fps";
+        if (text != hudString) {
+            hud.setString(text);
+            hudString = text;
+        }
+
+        window.clear(sf::Color(135, 206, 235));
+        window.draw(vertices, states);
+        window.draw(hud);
+        window.display();
+    }
+}
+
+// Fitness plot in the top right corner; at most one point per pixel column
+void Spectator::updatePlot(const std::vector<LiveFeedStats>& history) {
+    const float width = 300.0f, height = 120.0f;
+    const float left = WINDOW_WIDTH - width - 10.0f, top = 10.0f;
+    const sf::Color frameColor(255, 255, 255, 120);
+    const sf::Color bestColor(255, 215, 0);
+    const sf::Color averageColor(255, 255, 255);
+
+    size_t points = 0;
+    size_t stride = 1;
+    if (history.size() > 1) {
+        points = std::min(history.size(), static_cast<size_t>(width));
+        stride = (history.size() + points - 1) / points;
+        points = (history.size() + stride - 1) / stride;
+    }
+
+    plot.setPrimitiveType(sf::PrimitiveType::Lines);
+    plot.resize(8 + 4 * (points > 1 ? points - 1 : 0));
+    sf::Vector2f corners[4] = {{left, top}, {left + width, top},
+                               {left + width, top + height}, {left, top + height}};
+    for (int i = 0; i < 4; i++) {
+        plot[2 * i] = sf::Vertex{corners[i], frameColor};
+        plot[2 * i + 1] = sf::Vertex{corners[(i + 1) % 4], frameColor};
+    }
+    if (points < 2) {
+        return;
+    }
+
+    float maxFitness = 1.0f;
+    for (const auto& stats : history) {
+        maxFitness = std::max(maxFitness, stats.best);
+    }
+    auto at = [&](size_t point, float fitness) {
+        return sf::Vector2f(left + width * point / (points - 1),
+                            top + height * (1.0f - std::max(0.0f, fitness) / maxFitness));
+    };
+    size_t vertex = 8;
+    for (size_t point = 1; point < points; point++) {
+        const LiveFeedStats& previous = history[(point - 1) * stride];
+        const LiveFeedStats& current = history[std::min(point * stride, history.size() - 1)];
+        plot[vertex++] = sf::Vertex{at(point - 1, previous.best), bestColor};
+        plot[vertex++] = sf::Vertex{at(point, current.best), bestColor};
+        plot[vertex++] = sf::Vertex{at(point - 1, previous.average), averageColor};
+        plot[vertex++] = sf::Vertex{at(point, current.average), averageColor};
+    }
+}
+
+// Follow loop: poll the feed once per frame (a few atomic loads when idle)
+void Spectator::follow(sf::RenderWindow& window, const sf::Font& font, const std::string& feedName,
+                       unsigned int seed) {
+    sf::Text hud(font, "", 24);
+    hud.setPosition(sf::Vector2f(10.0f, 10.0f));
+    hud.setFillColor(sf::Color::White);
+    hud.setOutlineColor(sf::Color::Black);
+    hud.setOutlineThickness(2.0f);
+    std::string hudString;
+
+    LiveFeedReader feed;
+    std::vector<LiveFeedStats> history;
+    std::vector<float> genome;
+    unsigned int round = 0;
+    int swaps = 0;
+
+    flock.reset();
+    rankShade.assign(1, 0.0f);
+    vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
+    vertices.resize(static_cast<size_t>(2 + 2 * MAX_PIPES) * VERTICES_PER_QUAD);
+    buildTexture();
+    updatePlot(history);
+
+    sf::Clock attachClock;
+    bool firstAttempt = true;
+    const sf::RenderStates states(&texture);
+
+    while (window.isOpen()) {
+        bool newRound = false;
+        while (auto event = window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                window.close();
+            }
+            if (auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+                newRound = newRound || keyPressed->code == sf::Keyboard::Key::Space;
+            }
+        }
+
+        // Once a second: attach, or re-attach if a new run replaced the feed
+        if (firstAttempt || attachClock.getElapsedTime().asSeconds() >= 1.0f) {
+            firstAttempt = false;
+            attachClock.restart();
+            if ((!feed.isAttached() || feed.isStale(feedName)) && feed.attach(feedName)) {
+                std::cout << "Following " << feedName << "\n";
+                history.clear();
+                genome.clear();
+                flock.reset();
+                updatePlot(history);
+            }
+        }
+
+        if (feed.poll(history, genome) > 0 && !genome.empty()) {
+            if (!flock) {
+                flock = std::make_unique<Flock>(feed.getTopology());
+                flock->addGenome(genome);
+                flock->reset(seed + round);
+            } else {
+                flock->setGenome(0, genome);
+                swaps++;
+            }
+            updatePlot(history);
+        }
+
+        std::string text;
+        if (flock) {
+            if (!flock->step() || newRound) {
+                std::cout << "Round " << round << ": score " << flock->getScore() << " (generation "
+                          << history.back().generation << " champion)\n";
+                round++;
+                flock->reset(seed + round);
+            }
+            updateVertices();
+            const LiveFeedStats& latest = history.back();
+            text = "Generation " + std::to_string(latest.generation) + "   Best " +
+                   std::to_string(static_cast<int>(latest.best)) + "   Avg " +
+                   std::to_string(static_cast<int>(latest.average)) + "\nScore " +
+                   std::to_string(flock->getScore()) + "   Champions " + std::to_string(swaps + 1);
+        } else {
+            text = "Waiting for trainer on " + feedName;
+        }
+        if (text != hudString) {
+            hud.setString(text);
+            hudString = text;
+        }
+
+        window.clear(sf::Color(135, 206, 235));
+        if (flock) {
+            window.draw(vertices, states);
+        }
+        window.draw(plot);
+        window.draw(hud);
+        window.display();
+    }
+}
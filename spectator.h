@@ -0,0 +1,53 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "flock.h"
+#include "live_feed.h"
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Watch a whole population play one shared course
+// Ground, pipes and every bird are quads in one persistent sf::VertexArray
+// that is rewritten in place each frame and drawn with a single draw call;
+// birds sample a circle from a small generated texture, the flat shapes a
+// solid texel of it. The HUD is one cached sf::Text whose string only
+// changes when its contents do.
+class Spectator {
+public:
+    // Load the current generation of a population store (train
+    // --population-file); birds > 0 takes the best birds agents, repeating
+    // the population if it is smaller
+    bool load(const std::string& populationFile, int birds);
+
+    // Play rounds until the window is closed; Space starts a new course
+    void run(sf::RenderWindow& window, const sf::Font& font, unsigned int seed);
+
+    // Follow a training run (train --live-feed): fly its newest champion,
+    // swapping in each new one mid-flight, and plot best and average
+    // fitness per generation. Waits for the trainer if it has not started
+    // and re-attaches when a new run takes over the feed.
+    void follow(sf::RenderWindow& window, const sf::Font& font, const std::string& feedName,
+                unsigned int seed);
+
+private:
+    static const int MAX_PIPES = 8;
+    static const int VERTICES_PER_QUAD = 6;
+
+    std::unique_ptr<Flock> flock;
+    std::vector<float> rankShade;  // 0 = best agent, 1 = worst
+
+    sf::VertexArray vertices;
+    sf::VertexArray plot;  // lines: frame, then best and average curves
+    sf::Texture texture;
+
+    void buildTexture();
+    void setQuad(int quad, float x, float y, float width, float height,
+                 sf::Color color, bool textured);
+    void hideQuad(int quad);
+    void updateVertices();
+    void updatePlot(const std::vector<LiveFeedStats>& history);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "surrogate.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Constructor
+FitnessSurrogate::FitnessSurrogate(int numWeights, int capacity, int k)
+    : k(std::max(1, k)),
+      archive(std::max(1, capacity), numWeights),
+      archiveFitness(std::max(1, capacity), 0.0f),
+      count(0),
+      next(0),
+      normsValid(false) {
+}
+
+// Remember a simulated genome
+void FitnessSurrogate::add(const std::vector<float>& genome, float fitness) {
+    archive.setRow(next, genome);
+    archiveFitness[next] = fitness;
+    next = (next + 1) % archive.getRows();
+    count = std::min(count + 1, archive.getRows());
+    normsValid = false;
+}
+
+// Predict by inverse-distance weighting over the k nearest archive rows
+void FitnessSurrogate::predict(const GenomeMatrix& queries, std::vector<float>& predictions,
+                               WorkStealingScheduler& scheduler) {
+    int numQueries = queries.getRows();
+    predictions.assign(numQueries, 0.0f);
+    if (count == 0) {
+        return;
+    }
+    if (!normsValid) {
+        archive.computeNorms();
+        normsValid = true;
+    }
+
+    const int ROW_BLOCK = 64;
+    const int COL_BLOCK = 256;
+    int neighbours = std::min(k, count);
+
+    std::vector<WorkStealingScheduler::Task> tasks;
+    for (int rowBegin = 0; rowBegin < numQueries; rowBegin += ROW_BLOCK) {
+        tasks.push_back([&, rowBegin](int) {
+            int rowEnd = std::min(numQueries, rowBegin + ROW_BLOCK);
+            int rows = rowEnd - rowBegin;
+            std::vector<float> tile(ROW_BLOCK * COL_BLOCK);
+
+            // Best neighbours per row, kept sorted by distance (k is small)
+            std::vector<float> bestDistance(rows * neighbours, INFINITY);
+            std::vector<int> bestIndex(rows * neighbours, 0);
+
+            for (int colBegin = 0; colBegin < count; colBegin += COL_BLOCK) {
+                int colEnd = std::min(count, colBegin + COL_BLOCK);
+                squaredDistanceTile(queries, rowBegin, rowEnd, archive, colBegin, colEnd,
+                                    tile.data(), COL_BLOCK);
+                for (int r = 0; r < rows; r++) {
+                    const float* d = tile.data() + r * COL_BLOCK;
+                    float* distance = bestDistance.data() + r * neighbours;
+                    int* index = bestIndex.data() + r * neighbours;
+                    for (int j = 0; j < colEnd - colBegin; j++) {
+                        float value = std::max(0.0f, d[j]);
+                        if (value >= distance[neighbours - 1]) {
+                            continue;
+                        }
+                        int slot = neighbours - 1;
+                        while (slot > 0 && distance[slot - 1] > value) {
+                            distance[slot] = distance[slot - 1];
+                            index[slot] = index[slot - 1];
+                            slot--;
+                        }
+                        distance[slot] = value;
+                        index[slot] = colBegin + j;
+                    }
+                }
+            }
+
+            for (int r = 0; r < rows; r++) {
+                double weightSum = 0.0, fitnessSum = 0.0;
+                for (int n = 0; n < neighbours; n++) {
+                    double weight = 1.0 / (std::sqrt(bestDistance[r * neighbours + n]) + 1e-6);
+                    weightSum += weight;
+                    fitnessSum += weight * archiveFitness[bestIndex[r * neighbours + n]];
+                }
+                predictions[rowBegin + r] = static_cast<float>(fitnessSum / weightSum);
+            }
+        });
+    }
+    scheduler.run(tasks);
+}
+
+// Average ranks (1-based), ties share the mean of their positions
+static std::vector<double> ranks(const std::vector<float>& values) {
+    std::vector<int> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return values[a] < values[b]; });
+    std::vector<double> rank(values.size());
+    for (size_t i = 0; i < order.size();) {
+        size_t j = i;
+        while (j + 1 < order.size() && values[order[j + 1]] == values[order[i]]) {
+            j++;
+        }
+        double average = (i + j) / 2.0 + 1.0;
+        for (size_t t = i; t <= j; t++) {
+            rank[order[t]] = average;
+        }
+        i = j + 1;
+    }
+    return rank;
+}
+
+// Pearson correlation of the ranks
+float rankCorrelation(const std::vector<float>& a, const std::vector<float>& b) {
+    size_t n = std::min(a.size(), b.size());
+    if (n < 2) {
+        return 0.0f;
+    }
+    std::vector<double> ra = ranks(std::vector<float>(a.begin(), a.begin() + n));
+    std::vector<double> rb = ranks(std::vector<float>(b.begin(), b.begin() + n));
+    double mean = (n + 1) / 2.0;
+    double covariance = 0.0, varianceA = 0.0, varianceB = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        covariance += (ra[i] - mean) * (rb[i] - mean);
+        varianceA += (ra[i] - mean) * (ra[i] - mean);
+        varianceB += (rb[i] - mean) * (rb[i] - mean);
+    }
+    if (varianceA == 0.0 || varianceB == 0.0) {
+        return 0.0f;
+    }
+    return static_cast<float>(covariance / std::sqrt(varianceA * varianceB));
+}
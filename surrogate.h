@@ -0,0 +1,41 @@
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#include "genome_distance.h"
+#include "scheduler.h"
+#include <vector>
+
+// k-nearest-neighbour fitness surrogate
+// Remembers the last `capacity` simulated (genome, fitness) pairs and
+// predicts a genome's fitness as the inverse-distance weighted mean of its
+// k nearest remembered genomes. An exact match dominates the average, so a
+// genome that was simulated before gets (almost) its measured fitness back.
+class FitnessSurrogate {
+private:
+    int k;
+    GenomeMatrix archive;
+    std::vector<float> archiveFitness;
+    int count;  // filled rows
+    int next;   // row the next sample overwrites
+    bool normsValid;
+
+public:
+    FitnessSurrogate(int numWeights, int capacity, int k);
+
+    // Remember a simulated genome (overwrites the oldest once full)
+    void add(const std::vector<float>& genome, float fitness);
+
+    // Forget every remembered genome, e.g. when fitness changes scale
+    void clear() { count = 0; next = 0; normsValid = false; }
+
+    // Predict fitness of every row of queries, one task per block of rows
+    void predict(const GenomeMatrix& queries, std::vector<float>& predictions,
+                 WorkStealingScheduler& scheduler);
+
+    int size() const { return count; }
+};
+
+// Spearman rank correlation (ties get their average rank); 0 if undefined
+float rankCorrelation(const std::vector<float>& a, const std::vector<float>& b);
+
+#endif
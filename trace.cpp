@@ -0,0 +1,122 @@
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+namespace {
+
+const int MAX_TRACE_THREADS = 256;
+
+// Events recorded by one thread (only that thread writes to it)
+struct TraceBuffer {
+    std::unique_ptr<Tracer::Event[]> events;
+    size_t capacity;
+    std::atomic<size_t> size{0};
+    size_t dropped = 0;
+};
+
+std::atomic<TraceBuffer*> buffers[MAX_TRACE_THREADS];
+std::atomic<int> bufferCount{0};
+std::chrono::steady_clock::time_point traceStart;
+
+} // namespace
+
+std::atomic<bool> Tracer::enabled{false};
+int Tracer::gameSampleRate = 1;
+size_t Tracer::capacity = 0;
+
+// Turn tracing on
+void Tracer::enable(size_t eventsPerThread, int sampleRate) {
+    capacity = eventsPerThread;
+    gameSampleRate = sampleRate > 0 ? sampleRate : 1;
+    traceStart = std::chrono::steady_clock::now();
+    enabled.store(true);
+}
+
+// Nanoseconds since enable()
+uint64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceStart).count();
+}
+
+// Append to the calling thread's buffer (allocated on first use)
+void Tracer::record(const Event& event) {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        int index = bufferCount.fetch_add(1);
+        if (index >= MAX_TRACE_THREADS) {
+            return;  // too many threads; this one stays untraced
+        }
+        buffer = new TraceBuffer;
+        buffer->events.reset(new Event[capacity]);
+        buffer->capacity = capacity;
+        buffers[index].store(buffer, std::memory_order_release);
+    }
+
+    size_t size = buffer->size.load(std::memory_order_relaxed);
+    if (size >= buffer->capacity) {
+        buffer->dropped++;
+        return;
+    }
+    buffer->events[size] = event;
+    buffer->size.store(size + 1, std::memory_order_release);
+}
+
+void Tracer::complete(const char* name, uint64_t start, int64_t arg) {
+    uint64_t end = now();
+    record({name, 'X', arg, start, end - start});
+}
+
+void Tracer::asyncBegin(const char* name, int64_t id, uint64_t start) {
+    record({name, 'b', id, start, 0});
+}
+
+void Tracer::asyncEnd(const char* name, int64_t id, uint64_t end) {
+    record({name, 'e', id, end, 0});
+}
+
+// Write all buffers as Chrome trace-event JSON
+bool Tracer::writeJson(const std::string& path) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t dropped = 0;
+    int count = std::min(bufferCount.load(), MAX_TRACE_THREADS);
+
+    for (int tid = 0; tid < count; tid++) {
+        TraceBuffer* buffer = buffers[tid].load(std::memory_order_acquire);
+        if (!buffer) {
+            continue;
+        }
+        std::fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"name\":\"thread %d\"}}", first ? "" : ",\n", tid, tid);
+        first = false;
+
+        size_t size = buffer->size.load(std::memory_order_acquire);
+        for (size_t i = 0; i < size; i++) {
+            const Event& e = buffer->events[i];
+            // Chrome wants microseconds
+            std::fprintf(out, ",\n{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                         e.phase, e.name, tid, e.start / 1000.0);
+            if (e.phase == 'X') {
+                std::fprintf(out, ",\"dur\":%.3f", e.duration / 1000.0);
+                if (e.arg >= 0) {
+                    std::fprintf(out, ",\"args\":{\"id\":%lld}", static_cast<long long>(e.arg));
+                }
+            } else {
+                std::fprintf(out, ",\"cat\":\"%s\",\"id\":%lld", e.name, static_cast<long long>(e.arg));
+            }
+            std::fprintf(out, "}");
+        }
+        dropped += buffer->dropped;
+    }
+
+    std::fprintf(out, "\n],\"otherData\":{\"droppedEvents\":%zu}}\n", dropped);
+    return std::fclose(out) == 0;
+}
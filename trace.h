@@ -0,0 +1,83 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline tracing in Chrome trace-event format (open in Perfetto / chrome://tracing)
+// Each thread appends to its own fixed-size buffer, allocated on first use,
+// so recording never takes a lock. Full buffers drop events (and count them).
+// When tracing is disabled a span costs one relaxed load.
+class Tracer {
+public:
+    struct Event {
+        const char* name;  // must be a string literal
+        char phase;        // 'X' complete, 'b'/'e' async begin/end
+        int64_t arg;       // shown as args.id (agent / game index), -1 for none
+        uint64_t start;    // ns since enable()
+        uint64_t duration; // ns ('X' only)
+    };
+
+    // Turn tracing on; eventsPerThread bounds memory, every sampleRate-th
+    // game gets a span
+    static void enable(size_t eventsPerThread, int gameSampleRate);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Should the game with this index get a span?
+    static bool sampleGame(int index) { return index % gameSampleRate == 0; }
+
+    // Nanoseconds since enable()
+    static uint64_t now();
+
+    // Record events on the calling thread's buffer
+    static void complete(const char* name, uint64_t start, int64_t arg = -1);
+    static void asyncBegin(const char* name, int64_t id, uint64_t start);
+    static void asyncEnd(const char* name, int64_t id, uint64_t end);
+
+    // Write everything recorded so far as Chrome trace JSON
+    static bool writeJson(const std::string& path);
+
+private:
+    static std::atomic<bool> enabled;
+    static int gameSampleRate;
+    static size_t capacity;
+
+    static void record(const Event& event);
+};
+
+// RAII span that records a complete event on destruction
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, int64_t arg = -1)
+        : name(Tracer::isEnabled() ? name : nullptr), arg(arg), start(0) {
+        if (this->name) {
+            start = Tracer::now();
+        }
+    }
+    ~TraceScope() {
+        finish();
+    }
+
+    // End the span early
+    void finish() {
+        if (name) {
+            Tracer::complete(name, start, arg);
+            name = nullptr;
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    int64_t arg;
+    uint64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+
+#endif
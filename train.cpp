@@ -1,11 +1,62 @@
 #include "evolution.h"
 #include "neural_network.h"
 #include "simulation.h"
+#include "metrics_exporter.h"
+#include "trace.h"
+#include "network_export.h"
+#include "farm.h"
+#include "lineage_log.h"
+#include "live_feed.h"
+#include "behavior_cloning.h"
 #include <iostream>
+#include <algorithm>
 #include <iomanip>
 #include <random>
 #include <chrono>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
+
+// Mean fitness of an agent over a fixed set of courses (its own generator,
+// so the training stream is untouched)
+float testFitness(NeuralNetwork& agent, int courses,
+                  std::uniform_real_distribution<float>& gapSize,
+                  std::uniform_real_distribution<float>& gapY) {
+    auto agentFunction = [&agent](const std::vector<float>& features) -> bool {
+        return agent.forward(features) > 0.5f;
+    };
+    float total = 0.0f;
+    for (int course = 0; course < courses; course++) {
+        std::mt19937 courseGen(1000 + course);
+        total += simulateGame(courseGen, gapSize, gapY, agentFunction, 10000).fitness();
+    }
+    return total / courses;
+}
+
+// Average cost of one forward pass on random features, in nanoseconds
+double forwardNanoseconds(NeuralNetwork& agent) {
+    std::mt19937 featureGen(7);
+    std::uniform_real_distribution<float> feature(0.0f, 1.0f);
+    std::vector<std::vector<float>> inputs(1024, std::vector<float>(agent.getTopology()[0]));
+    for (auto& input : inputs) {
+        for (float& value : input) {
+            value = feature(featureGen);
+        }
+    }
+    const int passes = 200;
+    float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (const auto& input : inputs) {
+            sink += agent.forward(input);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    volatile float keep = sink;
+    (void)keep;
+    return seconds * 1e9 / (static_cast<double>(passes) * inputs.size());
+}
 
 void printUsage(const char* programName) {
     std::cout << "Usage: " << programName << " [options]\n";
@@ -18,6 +69,48 @@ void printUsage(const char* programName) {
     std::cout << "  -r, --elite-ratio RATIO   Elite ratio (default: 0.2)\n";
     std::cout << "  -t, --tournament-size NUM Tournament size (default: 3)\n";
     std::cout << "  -o, --output FILE         Output file for best agent (optional)\n";
+    std::cout << "      --export-header FILE  Export best agent as a C++ header (constexpr weights)\n";
+    std::cout << "  -j, --threads NUM         Evaluation threads (default: all cores)\n";
+    std::cout << "      --chunk-frames NUM    Frames per scheduling chunk (default: 1000)\n";
+    std::cout << "      --seed NUM            Random seed (default: random)\n";
+    std::cout << "      --metrics-port PORT   Serve Prometheus metrics on localhost:PORT\n";
+    std::cout << "      --metrics-file FILE   Periodically write Prometheus metrics to FILE\n";
+    std::cout << "      --metrics-interval S  Seconds between metrics file writes (default: 10)\n";
+    std::cout << "      --trace FILE          Write a Chrome trace-event timeline to FILE\n";
+    std::cout << "      --trace-buffer NUM    Max trace events per thread (default: 1000000)\n";
+    std::cout << "      --trace-sample NUM    Trace every NUM-th game (default: 1)\n";
+    std::cout << "      --sharing-radius R    Fitness sharing radius in genome space (default: off)\n";
+    std::cout << "      --species-threshold T Speciation distance threshold (default: off)\n";
+    std::cout << "      --distance-samples N  Approximate: niche counts from N sampled genomes, at most N species\n";
+    std::cout << "      --surrogate KEEP      Simulate only the KEEP fraction of agents a k-NN surrogate ranks best\n";
+    std::cout << "      --surrogate-explore F Also simulate F of the screened-out agents at random (default: 0.1)\n";
+    std::cout << "      --surrogate-k NUM     Neighbours per surrogate prediction (default: 5)\n";
+    std::cout << "      --horizon FRAMES      Start games capped at FRAMES, doubling as agents reach the cap (default: 10000)\n";
+    std::cout << "      --horizon-grow RATE   Double the cap once RATE of the games reach it (default: 0.05)\n";
+    std::cout << "      --rescore-interval N  Re-score elites without the cap every N evaluations (default: off)\n";
+    std::cout << "      --topology LIST       Layer sizes, 5 inputs to 1 output (default: 5,8,4,1)\n";
+    std::cout << "      --prune SPARSITY      Prune this fraction of connection weights by magnitude (default: off)\n";
+    std::cout << "      --prune-interval N    Prune every N generations, ramping up over the first half (default: after training)\n";
+    std::cout << "      --clone SOURCE        Warm-start by cloning 'heuristic' or a saved agent FILE\n";
+    std::cout << "      --clone-games NUM     Demonstration games per round (default: 20)\n";
+    std::cout << "      --clone-rounds NUM    Rounds; after the first the clone flies and is corrected (default: 5)\n";
+    std::cout << "      --clone-epochs NUM    Passes over the demonstrations per round (default: 10)\n";
+    std::cout << "      --clone-batch NUM     Minibatch size (default: 256)\n";
+    std::cout << "      --clone-rate RATE     Adam learning rate (default: 0.003)\n";
+    std::cout << "      --target-fitness F    Report the frames simulated until the best fitness reaches F\n";
+    std::cout << "      --lineage-log FILE    Log every genome as parents + crossover mask + mutation deltas\n";
+    std::cout << "      --keyframe-interval N Store children in full every N generations (default: 10)\n";
+    std::cout << "      --live-feed NAME      Publish each generation to shared memory NAME (flappy --follow)\n";
+    std::cout << "      --population-file FILE Keep the population in a memory-mapped FILE instead of RAM\n";
+    std::cout << "      --population-chunk N  Agents in RAM at once with --population-file (default: 4096)\n";
+    std::cout << "      --huge-pages          Keep the population and pending games on huge pages, NUMA aware\n";
+    std::cout << "      --genome-precision P  Store genomes as fp32, fp16 or bf16 (default: fp32)\n";
+    std::cout << "      --farm LIST           Evaluate on farm workers (comma separated host:port)\n";
+    std::cout << "      --farm-local NUM      Start NUM farm workers on this machine and use them\n";
+    std::cout << "      --farm-batch NUM      Agents per farm batch (default: 64)\n";
+    std::cout << "      --farm-depth NUM      Batches in flight per farm worker (default: 4)\n";
+    std::cout << "      --farm-timeout S      Drop a farm worker holding a batch this long (default: 30)\n";
+    std::cout << "      --worker [ADDR:]PORT  Run as a farm worker on ADDR (default: 127.0.0.1):PORT\n";
     std::cout << "  -h, --help                Show this help message\n";
 }
 
@@ -31,6 +124,49 @@ int main(int argc, char* argv[]) {
     float eliteRatio = 0.2f;
     int tournamentSize = 3;
     std::string outputFile = "";
+    std::string exportHeaderFile = "";
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    int chunkFrames = 1000;
+    bool fixedSeed = false;
+    unsigned int seed = 0;
+    int metricsPort = 0;
+    std::string metricsFile = "";
+    int metricsInterval = 10;
+    std::string traceFile = "";
+    int traceBuffer = 1000000;
+    int traceSample = 1;
+    float sharingRadius = 0.0f;
+    float speciesThreshold = 0.0f;
+    int distanceSamples = 0;
+    float surrogateKeep = 1.0f;
+    float surrogateExplore = 0.1f;
+    int surrogateNeighbours = 5;
+    int horizonStart = 0;
+    float horizonGrow = 0.05f;
+    int rescoreInterval = 0;
+    std::vector<int> topology = {5, 8, 4, 1};
+    float pruneSparsity = 0.0f;
+    std::string cloneSource = "";
+    int cloneGames = 20;
+    int cloneEpochs = 10;
+    int cloneRounds = 5;
+    int cloneBatch = 256;
+    float cloneRate = 0.003f;
+    float targetFitness = 0.0f;
+    int pruneInterval = 0;
+    std::string lineageFile = "";
+    std::string liveFeedName = "";
+    int keyframeInterval = 10;
+    std::string populationFile = "";
+    int populationChunk = 4096;
+    GenomePrecision genomePrecision = GenomePrecision::FP32;
+    bool hugePages = false;
+    std::vector<std::string> farmWorkers;
+    int farmLocal = 0;
+    int farmBatch = 64;
+    int farmDepth = 4;
+    double farmTimeout = 30.0;
+    std::string workerAddress = "";
     
     // Parse command-line arguments
     for (int i = 1; i < argc; i++) {
@@ -71,18 +207,227 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc) {
                 outputFile = argv[++i];
             }
+        } else if (arg == "--export-header") {
+            if (i + 1 < argc) {
+                exportHeaderFile = argv[++i];
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            if (i + 1 < argc) {
+                numThreads = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--chunk-frames") {
+            if (i + 1 < argc) {
+                chunkFrames = std::stoi(argv[++i]);
+                if (chunkFrames < 1) {
+                    std::cerr << "Error: --chunk-frames must be at least 1\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+                fixedSeed = true;
+            }
+        } else if (arg == "--metrics-port") {
+            if (i + 1 < argc) {
+                metricsPort = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--metrics-file") {
+            if (i + 1 < argc) {
+                metricsFile = argv[++i];
+            }
+        } else if (arg == "--metrics-interval") {
+            if (i + 1 < argc) {
+                metricsInterval = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                traceFile = argv[++i];
+            }
+        } else if (arg == "--trace-buffer") {
+            if (i + 1 < argc) {
+                traceBuffer = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--trace-sample") {
+            if (i + 1 < argc) {
+                traceSample = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--sharing-radius") {
+            if (i + 1 < argc) {
+                sharingRadius = std::stof(argv[++i]);
+            }
+        } else if (arg == "--species-threshold") {
+            if (i + 1 < argc) {
+                speciesThreshold = std::stof(argv[++i]);
+            }
+        } else if (arg == "--distance-samples") {
+            if (i + 1 < argc) {
+                distanceSamples = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--surrogate") {
+            if (i + 1 < argc) {
+                surrogateKeep = std::stof(argv[++i]);
+            }
+        } else if (arg == "--surrogate-explore") {
+            if (i + 1 < argc) {
+                surrogateExplore = std::stof(argv[++i]);
+            }
+        } else if (arg == "--surrogate-k") {
+            if (i + 1 < argc) {
+                surrogateNeighbours = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--horizon") {
+            if (i + 1 < argc) {
+                horizonStart = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--horizon-grow") {
+            if (i + 1 < argc) {
+                horizonGrow = std::stof(argv[++i]);
+            }
+        } else if (arg == "--rescore-interval") {
+            if (i + 1 < argc) {
+                rescoreInterval = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--topology") {
+            if (i + 1 < argc) {
+                topology.clear();
+                std::stringstream list(argv[++i]);
+                std::string layer;
+                while (std::getline(list, layer, ',')) {
+                    topology.push_back(std::stoi(layer));
+                }
+            }
+        } else if (arg == "--prune") {
+            if (i + 1 < argc) {
+                pruneSparsity = std::stof(argv[++i]);
+            }
+        } else if (arg == "--prune-interval") {
+            if (i + 1 < argc) {
+                pruneInterval = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--clone") {
+            if (i + 1 < argc) {
+                cloneSource = argv[++i];
+            }
+        } else if (arg == "--clone-games") {
+            if (i + 1 < argc) {
+                cloneGames = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--clone-epochs") {
+            if (i + 1 < argc) {
+                cloneEpochs = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--clone-rounds") {
+            if (i + 1 < argc) {
+                cloneRounds = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--clone-batch") {
+            if (i + 1 < argc) {
+                cloneBatch = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--clone-rate") {
+            if (i + 1 < argc) {
+                cloneRate = std::stof(argv[++i]);
+            }
+        } else if (arg == "--target-fitness") {
+            if (i + 1 < argc) {
+                targetFitness = std::stof(argv[++i]);
+            }
+        } else if (arg == "--lineage-log") {
+            if (i + 1 < argc) {
+                lineageFile = argv[++i];
+            }
+        } else if (arg == "--keyframe-interval") {
+            if (i + 1 < argc) {
+                keyframeInterval = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--live-feed") {
+            if (i + 1 < argc) {
+                liveFeedName = argv[++i];
+            }
+        } else if (arg == "--population-file") {
+            if (i + 1 < argc) {
+                populationFile = argv[++i];
+            }
+        } else if (arg == "--population-chunk") {
+            if (i + 1 < argc) {
+                populationChunk = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--huge-pages") {
+            hugePages = true;
+        } else if (arg == "--genome-precision") {
+            if (i + 1 < argc && !parseGenomePrecision(argv[++i], genomePrecision)) {
+                std::cerr << "Error: unknown genome precision " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--farm") {
+            if (i + 1 < argc) {
+                std::stringstream list(argv[++i]);
+                std::string address;
+                while (std::getline(list, address, ',')) {
+                    farmWorkers.push_back(address);
+                }
+            }
+        } else if (arg == "--farm-local") {
+            if (i + 1 < argc) {
+                farmLocal = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--farm-batch") {
+            if (i + 1 < argc) {
+                farmBatch = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--farm-depth") {
+            if (i + 1 < argc) {
+                farmDepth = std::stoi(argv[++i]);
+            }
+        } else if (arg == "--farm-timeout") {
+            if (i + 1 < argc) {
+                farmTimeout = std::stod(argv[++i]);
+            }
+        } else if (arg == "--worker") {
+            if (i + 1 < argc) {
+                workerAddress = argv[++i];
+            }
+        }
+    }
+    
+    if (topology.size() < 2 || topology.front() != 5 || topology.back() != 1 ||
+        *std::min_element(topology.begin(), topology.end()) <= 0) {
+        std::cerr << "Error: topology must run from 5 inputs to 1 output\n";
+        return 1;
+    }
+    
+    if (!traceFile.empty()) {
+        Tracer::enable(traceBuffer, traceSample);
+    }
+    
+    // Worker mode: serve evaluation batches until killed
+    if (!workerAddress.empty()) {
+        size_t colon = workerAddress.rfind(':');
+        std::string host = colon == std::string::npos ? "127.0.0.1" : workerAddress.substr(0, colon);
+        int port = std::stoi(colon == std::string::npos ? workerAddress : workerAddress.substr(colon + 1));
+        std::cout << "Farm worker on " << host << ":" << port << " with " << numThreads << " threads" << std::endl;
+        return runFarmWorker(host, port, numThreads, -1, false);
+    }
+    
+    // Local farm workers are forked before this process starts any threads;
+    // they are killed and reaped however main returns
+    LocalFarmWorkers localFarmWorkers;
+    if (farmLocal > 0) {
+        int threadsPerWorker = std::max(1, numThreads / farmLocal);
+        if (!localFarmWorkers.spawn(farmLocal, threadsPerWorker, farmWorkers)) {
+            std::cerr << "Error: could not start local farm workers\n";
+            return 1;
         }
     }
     
     // Initialize random number generators
     std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(fixedSeed ? seed : rd());
     std::uniform_real_distribution<float> gapSize(150.0f, 250.0f);
     std::uniform_real_distribution<float> gapY(200.0f, WINDOW_HEIGHT - 250.0f);
     
-    // Network topology: 5 inputs → 8 hidden → 4 hidden → 1 output
-    std::vector<int> topology = {5, 8, 4, 1};
-    
     // Print configuration
     std::cout << "=== Evolutionary Flappy Bird Training ===\n\n";
     std::cout << "Configuration:\n";
@@ -93,6 +438,61 @@ int main(int argc, char* argv[]) {
     std::cout << "  Mutation strength: " << mutationStrength << "\n";
     std::cout << "  Elite ratio: " << eliteRatio << "\n";
     std::cout << "  Tournament size: " << tournamentSize << "\n";
+    std::cout << "  Threads: " << numThreads << "\n";
+    if (!populationFile.empty()) {
+        std::cout << "  Population file: " << populationFile
+                  << " (" << populationChunk << " agents per chunk)\n";
+    }
+    if (!farmWorkers.empty()) {
+        std::cout << "  Farm workers: " << farmWorkers.size() << " (" << farmBatch
+                  << " agents per batch, " << farmDepth << " in flight)\n";
+    }
+    if (genomePrecision != GenomePrecision::FP32) {
+        std::cout << "  Genome precision: " << genomePrecisionName(genomePrecision) << "\n";
+    }
+    if (sharingRadius > 0.0f) {
+        std::cout << "  Fitness sharing radius: " << sharingRadius;
+        if (distanceSamples > 0) {
+            std::cout << " (" << distanceSamples << " sampled genomes)";
+        }
+        std::cout << "\n";
+    }
+    if (speciesThreshold > 0.0f) {
+        std::cout << "  Species threshold: " << speciesThreshold;
+        if (distanceSamples > 0) {
+            std::cout << " (at most " << distanceSamples << " species)";
+        }
+        std::cout << "\n";
+    }
+    bool useSurrogate = surrogateKeep > 0.0f && surrogateKeep < 1.0f;
+    if (!lineageFile.empty()) {
+        std::cout << "  Lineage log: " << lineageFile << " (keyframes every "
+                  << keyframeInterval << " generations)\n";
+    }
+    bool adaptiveHorizon = horizonStart > 0 && horizonStart < 10000;
+    if (adaptiveHorizon) {
+        std::cout << "  Horizon: " << horizonStart << " frames, doubling at " << horizonGrow
+                  << " of games at the cap";
+        if (rescoreInterval > 0) {
+            std::cout << " (elites re-scored every " << rescoreInterval << " evaluations)";
+        }
+        std::cout << "\n";
+    }
+    bool pruning = pruneSparsity > 0.0f;
+    if (pruning) {
+        std::cout << "  Pruning: " << pruneSparsity << " of connection weights";
+        if (pruneInterval > 0) {
+            std::cout << " (every " << pruneInterval << " generations)";
+        }
+        std::cout << "\n";
+    }
+    if (!liveFeedName.empty()) {
+        std::cout << "  Live feed: " << liveFeedName << "\n";
+    }
+    if (useSurrogate) {
+        std::cout << "  Surrogate: simulate best " << surrogateKeep << " + explore "
+                  << surrogateExplore << " (k = " << surrogateNeighbours << ")\n";
+    }
     std::cout << "  Network topology: ";
     for (size_t i = 0; i < topology.size(); i++) {
         std::cout << topology[i];
@@ -103,16 +503,144 @@ int main(int argc, char* argv[]) {
     // Create evolution object
     Evolution evolution(populationSize, topology, gamesPerEvaluation,
                        mutationRate, mutationStrength, eliteRatio, tournamentSize,
-                       gen, gapSize, gapY);
+                       gen, gapSize, gapY, populationFile, genomePrecision,
+                       hugePages && populationFile.empty());
+    if (!evolution.isReady()) {
+        std::cerr << "Error: could not create population store " << populationFile << "\n";
+        return 1;
+    }
+    evolution.setNumThreads(numThreads);
+    evolution.setPopulationChunk(populationChunk);
+    if (hugePages && populationFile.empty()) {
+        std::cout << "  Population memory: " << pageKindName(evolution.getPageKind()) << " ("
+                  << numaNodeCount() << " NUMA node" << (numaNodeCount() > 1 ? "s" : "")
+                  << ")\n\n";
+    }
+    
+    // Connect to the evaluation farm if requested
+    std::unique_ptr<EvaluationFarm> farm;
+    if (!farmWorkers.empty()) {
+        farm = std::make_unique<EvaluationFarm>(farmWorkers, farmBatch, farmDepth);
+        farm->setBatchTimeout(farmTimeout);
+        if (!farm->connect(topology, gapSize, gapY)) {
+            std::cerr << "Error: could not reach any farm worker\n";
+            return 1;
+        }
+        evolution.setFarm(farm.get());
+    }
+    evolution.setChunkFrames(chunkFrames);
+    evolution.setFitnessSharing(sharingRadius);
+    evolution.setSpeciation(speciesThreshold);
+    evolution.setDistanceSamples(distanceSamples);
+    evolution.setSurrogate(surrogateKeep, surrogateExplore, surrogateNeighbours);
+    evolution.setAdaptiveHorizon(adaptiveHorizon ? horizonStart : 0, horizonGrow, rescoreInterval);
+    
+    // Warm start: fit the initial network to a demonstrator's decisions
+    uint64_t cloneFrames = 0;
+    if (!cloneSource.empty()) {
+        std::unique_ptr<NeuralNetwork> demonstrator;
+        if (cloneSource != "heuristic") {
+            demonstrator = NeuralNetwork::load(cloneSource);
+            if (!demonstrator || demonstrator->getTopology().front() != 5 ||
+                demonstrator->getTopology().back() != 1) {
+                std::cerr << "Error: could not load a 5-input, 1-output network from " << cloneSource << "\n";
+                return 1;
+            }
+        }
+        auto policy = [&demonstrator](const std::vector<float>& features) -> bool {
+            return demonstrator ? demonstrator->forward(features) > 0.5f : heuristicFlap(features);
+        };
+        uint64_t cloneSeed = gen();
+        auto cloneStart = std::chrono::steady_clock::now();
+        std::cout << "Behavioral cloning of " << cloneSource << ": " << cloneRounds << " rounds of "
+                  << cloneGames << " games, " << cloneEpochs << " epochs each\n" << std::fixed;
+        
+        // Round 0 records the demonstrator; later rounds let the clone fly and
+        // the demonstrator label where it goes (dataset aggregation)
+        NeuralNetwork clone = evolution.getBestAgent();
+        auto clonePolicy = [&clone](const std::vector<float>& features) -> bool {
+            return clone.forward(features) > 0.5f;
+        };
+        Policy demonstratorPolicy = policy;
+        Policy cloneDriver = clonePolicy;
+        BehaviorCloner cloner(topology, numThreads, cloneRate);
+        Rng cloneRng(cloneSeed, 0);
+        cloner.initialize(clone, cloneRng);
+        Demonstrations demonstrations;
+        for (int round = 0; round < cloneRounds; round++) {
+            recordDemonstrations(demonstratorPolicy, round == 0 ? demonstratorPolicy : cloneDriver,
+                                 cloneGames, cloneSeed + round, demonstrations);
+            BehaviorCloner::EpochStats stats{0.0f, 0.0f};
+            for (int epoch = 0; epoch < cloneEpochs; epoch++) {
+                stats = cloner.trainEpoch(clone, demonstrations, cloneBatch, cloneRng);
+            }
+            std::cout << "  Round " << round + 1 << ": " << demonstrations.size() << " decisions, loss "
+                      << std::setprecision(4) << stats.loss << ", " << std::setprecision(1)
+                      << 100.0f * stats.accuracy << "% match, clone scores " << std::setprecision(2)
+                      << testFitness(clone, 20, gapSize, gapY) << " on 20 test courses\n";
+        }
+        cloneFrames = demonstrations.frames;
+        double cloneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - cloneStart).count();
+        std::cout << "  " << std::setprecision(1) << cloneFrames / 1e6 << "M frames recorded, "
+                  << cloneSeconds << " s\n\n" << std::defaultfloat;
+        evolution.seedPopulation(clone);
+    }
+    
+    // Start the lineage log (writes the initial population)
+    LineageLog lineageLog;
+    if (!lineageFile.empty()) {
+        int numWeights = evolution.getBestAgent().getNumWeights();
+        if (!lineageLog.open(lineageFile, topology, numWeights, genomePrecision, keyframeInterval)) {
+            std::cerr << "Error: could not write lineage log " << lineageFile << "\n";
+            return 1;
+        }
+        evolution.setLineageLog(&lineageLog);
+    }
+    
+    // Open the live feed; viewers attach and detach on their own
+    LiveFeedWriter liveFeed;
+    if (!liveFeedName.empty() &&
+        !liveFeed.create(liveFeedName, topology, evolution.getBestAgent().getNumWeights())) {
+        std::cerr << "Error: could not create live feed " << liveFeedName << "\n";
+        return 1;
+    }
+    
+    // Start metrics export if requested
+    MetricsExporter metrics(metricsPort, metricsFile, metricsInterval);
+    if (metricsPort > 0 || !metricsFile.empty()) {
+        if (!metrics.start()) {
+            std::cerr << "Error: could not bind metrics port " << metricsPort << "\n";
+            return 1;
+        }
+        if (metricsPort > 0) {
+            std::cout << "Metrics: http://127.0.0.1:" << metricsPort << "/metrics\n";
+        }
+        if (!metricsFile.empty()) {
+            std::cout << "Metrics file: " << metricsFile << "\n";
+        }
+        std::cout << "\n";
+    }
     
     // Training loop
     float bestFitnessEver = 0.0f;
     int bestGeneration = 0;
+    double distanceSeconds = 0.0;
+    double evolveSeconds = 0.0;
+    uint64_t gamesSimulated = 0;
+    uint64_t gamesSkipped = 0;
+    float correlationSum = 0.0f;
+    uint64_t framesSimulated = 0;
+    uint64_t framesSaved = 0;
+    const int pruneTestCourses = 20;
+    int targetGeneration = -1;
+    uint64_t targetFrames = 0;
     
     std::cout << "Starting training...\n";
     std::cout << std::fixed << std::setprecision(2);
-    std::cout << "\nGeneration | Best Fitness | Avg Fitness | Worst Fitness | Time (s)\n";
-    std::cout << "-----------|--------------|-------------|---------------|----------\n";
+    std::cout << "\nGeneration | Best Fitness | Avg Fitness | Worst Fitness | Time (s)";
+    std::cout << (adaptiveHorizon ? " | Horizon | Avg/Frame | Saved\n" : "\n");
+    std::cout << "-----------|--------------|-------------|---------------|----------";
+    std::cout << (adaptiveHorizon ? "|---------|-----------|------\n" : "\n");
     
     auto startTime = std::chrono::steady_clock::now();
     
@@ -120,11 +648,14 @@ int main(int argc, char* argv[]) {
         auto genStartTime = std::chrono::steady_clock::now();
         
         // Evolve one generation
+        TraceScope generationSpan("generation", generation);
         evolution.evolve();
+        generationSpan.finish();
         
         // Get statistics
         float best, average, worst;
         evolution.getStatistics(best, average, worst);
+        metrics.setGeneration(generation, best, average, worst);
         
         // Track best ever
         if (best > bestFitnessEver) {
@@ -135,13 +666,58 @@ int main(int argc, char* argv[]) {
         auto genEndTime = std::chrono::steady_clock::now();
         auto genDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
             genEndTime - genStartTime).count() / 1000.0;
+        distanceSeconds += evolution.getDistanceSeconds();
+        gamesSimulated += evolution.getGamesSimulated();
+        gamesSkipped += evolution.getGamesSkipped();
+        correlationSum += evolution.getSurrogateCorrelation();
+        framesSimulated += evolution.getFramesSimulated();
+        framesSaved += evolution.getFramesSaved();
+        evolveSeconds += std::chrono::duration<double>(genEndTime - genStartTime).count();
+        if (targetFitness > 0.0f && targetGeneration < 0 && best >= targetFitness) {
+            targetGeneration = generation;
+            targetFrames = framesSimulated;
+        }
+        if (!liveFeedName.empty()) {
+            liveFeed.publish({static_cast<uint64_t>(generation), best, average, worst,
+                              static_cast<float>(genDuration)},
+                             evolution.getBestAgent().getWeights());
+        }
         
         // Print statistics
         std::cout << std::setw(10) << generation << " | "
                   << std::setw(12) << best << " | "
                   << std::setw(11) << average << " | "
                   << std::setw(13) << worst << " | "
-                  << std::setw(9) << std::setprecision(2) << genDuration << "\n";
+                  << std::setw(9) << std::setprecision(2) << genDuration;
+        if (adaptiveHorizon) {
+            // Average fitness per frame of the cap (comparable across cap sizes),
+            // and the frames the full horizon would have cost at most, as a
+            // share of that total
+            uint64_t frames = evolution.getFramesSimulated();
+            uint64_t saved = evolution.getFramesSaved();
+            std::cout << " | " << std::setw(7) << evolution.getHorizon() << " | "
+                      << std::setw(9) << average / evolution.getHorizon() << " | "
+                      << std::setw(4) << std::setprecision(0)
+                      << (100.0 * saved / std::max<uint64_t>(1, frames + saved)) << "%"
+                      << std::setprecision(2);
+        }
+        std::cout << "\n";
+        
+        // Periodic pruning ramps up to the target over the first half of the run
+        if (pruning && pruneInterval > 0 && (generation + 1) % pruneInterval == 0) {
+            float ramp = std::min(1.0f, (generation + 1) / std::max(1.0f, numGenerations / 2.0f));
+            float previous = evolution.getSparsity();
+            NeuralNetwork before = evolution.getBestAgent();
+            float reached = evolution.prune(pruneSparsity * ramp);
+            if (reached > previous) {
+                NeuralNetwork after = evolution.getBestAgent();
+                std::cout << "Pruned to " << std::setprecision(1) << (100.0 * reached)
+                          << "% sparsity: best agent " << std::setprecision(2)
+                          << testFitness(before, pruneTestCourses, gapSize, gapY) << " -> "
+                          << testFitness(after, pruneTestCourses, gapSize, gapY) << " on "
+                          << pruneTestCourses << " test courses\n";
+            }
+        }
         
         // Print progress every 10 generations
         if ((generation + 1) % 10 == 0) {
@@ -149,7 +725,54 @@ int main(int argc, char* argv[]) {
                       << " generations (" << std::setprecision(1) 
                       << (100.0 * (generation + 1) / numGenerations) << "%)\n";
             std::cout << "Best fitness so far: " << std::setprecision(2) << bestFitnessEver 
-                      << " (generation " << bestGeneration << ")\n\n";
+                      << " (generation " << bestGeneration << ")\n";
+            if (speciesThreshold > 0.0f) {
+                std::cout << "Species: " << evolution.getSpeciesCount() << "\n";
+            }
+            if (sharingRadius > 0.0f || speciesThreshold > 0.0f) {
+                std::cout << "Distance phase: " << std::setprecision(1)
+                          << (100.0 * distanceSeconds / evolveSeconds)
+                          << "% of generation time\n" << std::setprecision(2);
+            }
+            if (useSurrogate) {
+                std::cout << "Surrogate: " << gamesSkipped << " of " << (gamesSimulated + gamesSkipped)
+                          << " games skipped, rank correlation " << evolution.getSurrogateCorrelation()
+                          << "\n";
+            }
+            std::cout << "\n";
+        }
+    }
+    
+    metrics.stop();
+    
+    if (!lineageFile.empty()) {
+        uint64_t bestId = evolution.getBestLineageId();
+        evolution.setLineageLog(nullptr);
+        lineageLog.close();
+        std::cout << "\nLineage log: " << lineageLog.getRecordsWritten() << " genomes, "
+                  << std::setprecision(1) << lineageLog.getBytesWritten() / 1048576.0 << " MB ("
+                  << static_cast<double>(lineageLog.getBytesWritten()) /
+                     std::max<uint64_t>(1, lineageLog.getRecordsWritten())
+                  << " bytes per genome), best agent is id " << bestId << "\n"
+                  << std::setprecision(2);
+    }
+    
+    if (farm) {
+        std::cout << "\nFarm: " << farm->getLiveWorkers() << "/" << farmWorkers.size()
+                  << " workers alive, " << farm->getBatchesSent() << " batches sent ("
+                  << farm->getBatchesReassigned() << " reassigned), " << std::setprecision(1)
+                  << farm->getBytesSent() / 1048576.0 << " MB out, "
+                  << farm->getBytesReceived() / 1048576.0 << " MB in\n" << std::setprecision(2);
+        evolution.setFarm(nullptr);
+        farm.reset();
+        localFarmWorkers.stop();
+    }
+    
+    if (!traceFile.empty()) {
+        if (Tracer::writeJson(traceFile)) {
+            std::cout << "\nTrace written to " << traceFile << "\n";
+        } else {
+            std::cerr << "Error: could not write trace to " << traceFile << "\n";
         }
     }
     
@@ -169,6 +792,57 @@ int main(int argc, char* argv[]) {
     std::cout << "  Best: " << finalBest << "\n";
     std::cout << "  Average: " << finalAvg << "\n";
     std::cout << "  Worst: " << finalWorst << "\n";
+    if (useSurrogate) {
+        std::cout << "Surrogate: " << gamesSkipped << " simulated games saved ("
+                  << std::setprecision(1) << (100.0 * gamesSkipped / std::max<uint64_t>(1, gamesSimulated + gamesSkipped))
+                  << "%), mean rank correlation " << std::setprecision(2)
+                  << correlationSum / std::max(1, numGenerations) << "\n";
+    }
+    
+    if (adaptiveHorizon) {
+        std::cout << "Horizon: " << evolution.getHorizon() << " frames, " << std::setprecision(1)
+                  << framesSimulated / 1e6 << "M frames simulated, up to " << framesSaved / 1e6
+                  << "M saved (" << (100.0 * framesSaved / std::max<uint64_t>(1, framesSimulated + framesSaved))
+                  << "%)\n" << std::setprecision(2);
+    }
+    
+    if (targetFitness > 0.0f) {
+        std::cout << "Target fitness " << targetFitness << ": " << std::setprecision(1);
+        if (targetGeneration >= 0) {
+            std::cout << "reached in generation " << targetGeneration << " after "
+                      << targetFrames / 1e6 << "M frames simulated";
+        } else {
+            std::cout << "not reached in " << numGenerations << " generations ("
+                      << framesSimulated / 1e6 << "M frames simulated)";
+        }
+        if (!cloneSource.empty()) {
+            std::cout << ", plus " << cloneFrames / 1e6 << "M recording demonstrations";
+        }
+        std::cout << "\n" << std::setprecision(2);
+    }
+    
+    // Prune after training (or finish the schedule), then report the effect
+    if (pruning) {
+        const int courses = 100;
+        NeuralNetwork unpruned = evolution.getBestAgent();
+        float previous = evolution.getSparsity();
+        bool finalStep = evolution.prune(pruneSparsity) > previous;
+        NeuralNetwork pruned = evolution.getBestAgent();
+        NeuralNetwork dense(topology, pruned.getWeights());
+        double denseNs = forwardNanoseconds(dense);
+        double sparseNs = forwardNanoseconds(pruned);
+        const PruneMask& mask = *pruned.getPruneMask();
+        std::cout << "Pruning: " << mask.numPruned << "/" << mask.numConnections
+                  << " connection weights (" << std::setprecision(1) << (100.0 * evolution.getSparsity())
+                  << "% sparsity)\n";
+        std::cout << "  Forward pass: " << denseNs << " ns dense, " << sparseNs << " ns sparse ("
+                  << std::setprecision(2) << denseNs / sparseNs << "x)\n";
+        std::cout << "  Best agent on " << courses << " test courses: ";
+        if (finalStep) {
+            std::cout << testFitness(unpruned, courses, gapSize, gapY) << " before the last pruning, ";
+        }
+        std::cout << testFitness(pruned, courses, gapSize, gapY) << (finalStep ? " after\n" : "\n");
+    }
     
     // Get best agent
     NeuralNetwork bestAgent = evolution.getBestAgent();
@@ -189,15 +863,21 @@ int main(int argc, char* argv[]) {
     
     // Save best agent if output file specified
     if (!outputFile.empty()) {
-        // For now, just print a message (full serialization would require more work)
-        std::cout << "\nNote: Agent serialization not yet implemented.\n";
-        std::cout << "Best agent topology: ";
-        const auto& topo = bestAgent.getTopology();
-        for (size_t i = 0; i < topo.size(); i++) {
-            std::cout << topo[i];
-            if (i < topo.size() - 1) std::cout << " → ";
+        if (bestAgent.save(outputFile, genomePrecision)) {
+            std::cout << "\nBest agent saved to " << outputFile << "\n";
+        } else {
+            std::cerr << "Error: could not save best agent to " << outputFile << "\n";
+            return 1;
         }
-        std::cout << "\n";
+    }
+    
+    // Export best agent as generated C++ (checked by the export_header test)
+    if (!exportHeaderFile.empty()) {
+        if (!exportNetworkHeader(bestAgent, exportHeaderFile)) {
+            std::cerr << "Error: could not write " << exportHeaderFile << "\n";
+            return 1;
+        }
+        std::cout << "\nExported best agent to " << exportHeaderFile << "\n";
     }
     
     return 0;